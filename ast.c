@@ -5,6 +5,8 @@
 #include <assert.h>
 #include <string.h>
 
+extern int yylineno;
+
 /* local helper functions */
 char *get_indent_str(int n)
 {
@@ -19,6 +21,7 @@ astNode *createProg(vector<astNode *> *exts, astNode *func)
 {
 	astNode *node;
 	node = (astNode *)calloc(1, sizeof(astNode));
+	node->line = yylineno;
 	node->type = ast_prog;
 	node->prog.exts = exts;
 	node->prog.func = func;
@@ -43,6 +46,7 @@ astNode *createFunc(const char *name, var_type type, vector<astNode *> *params,
 {
 	astNode *node;
 	node = (astNode *)calloc(1, sizeof(astNode));
+	node->line = yylineno;
 	node->type = ast_func;
 
 	node->func.name = (char *)calloc(1, sizeof(char) * (strlen(name) + 1));
@@ -84,6 +88,7 @@ astNode *createExtern(const char *name)
 {
 	astNode *node;
 	node = (astNode *)calloc(1, sizeof(astNode));
+	node->line = yylineno;
 	node->type = ast_extern;
 
 	node->ext.name = (char *)calloc(1, sizeof(char) * (strlen(name) + 1));
@@ -108,6 +113,7 @@ astNode *createVar(const char *name)
 {
 	astNode *node;
 	node = (astNode *)calloc(1, sizeof(astNode));
+	node->line = yylineno;
 	node->type = ast_var;
 
 	node->var.name = (char *)calloc(1, sizeof(char) * (strlen(name) + 1));
@@ -133,6 +139,7 @@ astNode *createCnst(int value)
 {
 	astNode *node;
 	node = (astNode *)calloc(1, sizeof(astNode));
+	node->line = yylineno;
 	node->type = ast_cnst;
 
 	node->cnst.value = value;
@@ -152,6 +159,7 @@ astNode *createRExpr(astNode *lhs, astNode *rhs, op_type op)
 {
 	astNode *node;
 	node = (astNode *)calloc(1, sizeof(astNode));
+	node->line = yylineno;
 	node->type = ast_rexpr;
 
 	node->rexpr.lhs = lhs;
@@ -178,6 +186,7 @@ astNode *createBExpr(astNode *lhs, astNode *rhs, op_type op)
 {
 	astNode *node;
 	node = (astNode *)calloc(1, sizeof(astNode));
+	node->line = yylineno;
 	node->type = ast_bexpr;
 
 	node->bexpr.lhs = lhs;
@@ -205,6 +214,7 @@ astNode *createUExpr(astNode *expr, op_type op)
 {
 	astNode *node;
 	node = (astNode *)calloc(1, sizeof(astNode));
+	node->line = yylineno;
 	node->type = ast_uexpr;
 
 	node->uexpr.expr = expr;
@@ -228,6 +238,7 @@ astNode *createCall(const char *name, vector<astNode *> *params)
 {
 	astNode *node;
 	node = (astNode *)calloc(1, sizeof(astNode));
+	node->line = yylineno;
 	node->type = ast_stmt;
 	node->stmt.type = ast_call;
 
@@ -262,6 +273,7 @@ astNode *createRet(astNode *expr)
 {
 	astNode *node;
 	node = (astNode *)calloc(1, sizeof(astNode));
+	node->line = yylineno;
 	node->type = ast_stmt;
 	node->stmt.type = ast_ret;
 
@@ -284,6 +296,7 @@ astNode *createBlock(vector<astNode *> *stmt_list)
 {
 	vector<astNode *> slist;
 	astNode *node = (astNode *)calloc(1, sizeof(astNode));
+	node->line = yylineno;
 	node->type = ast_stmt;
 	node->stmt.type = ast_block;
 
@@ -315,6 +328,7 @@ void freeBlock(astNode *node)
 astNode *createWhile(astNode *cond, astNode *body)
 {
 	astNode *node = (astNode *)calloc(1, sizeof(astNode));
+	node->line = yylineno;
 	node->type = ast_stmt;
 	node->stmt.type = ast_while;
 
@@ -340,6 +354,7 @@ void freeWhile(astNode *node)
 astNode *createIf(astNode *cond, astNode *ifbody, astNode *elsebody)
 {
 	astNode *node = (astNode *)calloc(1, sizeof(astNode));
+	node->line = yylineno;
 	node->type = ast_stmt;
 	node->stmt.type = ast_if;
 
@@ -369,6 +384,7 @@ void freeIf(astNode *node)
 astNode *createDecl(const char *name, var_type type)
 {
 	astNode *node = (astNode *)calloc(1, sizeof(astNode));
+	node->line = yylineno;
 	node->type = ast_stmt;
 	node->stmt.type = ast_decl;
 
@@ -392,6 +408,7 @@ void freeDecl(astNode *node)
 astNode *createAsgn(astNode *lhs, astNode *rhs)
 {
 	astNode *node = (astNode *)calloc(1, sizeof(astNode));
+	node->line = yylineno;
 	node->type = ast_stmt;
 	node->stmt.type = ast_asgn;
 
@@ -550,7 +567,7 @@ void printNode(astNode *node, int n)
 	}
 	case ast_extern:
 	{
-		printf("%sExtern: %s\n", indent, node->ext.name);
+		printf("%sExtern: %s%s\n", indent, node->ext.name, node->ext.pure ? " (pure)" : "");
 		break;
 	}
 	case ast_var:
@@ -88,6 +88,7 @@ typedef struct
 	char *name; // For extern functions defined we will only save function names
 	var_type type;
 	vector<var_type> *args;
+	bool pure; // no side effects, returns for every argument
 } astExtern;
 
 typedef struct
@@ -187,6 +188,7 @@ struct ast_Stmt
 struct ast_Node
 {
 	node_type type;
+	int line; // source line the lexer was on when the node was created
 	union
 	{
 		astProg prog;
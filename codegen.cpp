@@ -81,8 +81,8 @@ void generateAssemblyCode(Module &module, string asmFileName)
   TargetOptions options;
   options.MCOptions.AsmVerbose = true; // Enable verbose assembly output
 
-  // Create the target machine
-  TargetMachine *targetMachine = target->createTargetMachine(triple.getTriple(), "", "", options, Optional<Reloc::Model>());
+  // Create the target machine, position independent so globals such as profile counters link into PIE executables
+  TargetMachine *targetMachine = target->createTargetMachine(triple.getTriple(), "", "", options, Reloc::PIC_);
   if (!targetMachine)
   {
     errs() << "Failed to create target machine\n";
@@ -147,6 +147,11 @@ void computeLiveness(BasicBlock &block, map<Value *, int> &instIdx, map<Value *,
     {
       get<1>(liveRange[op2]) = count;
     }
+    // a select's false value is its third operand
+    if (opCode == Instruction::Select && liveRange.find(inst.getOperand(2)) != liveRange.end())
+    {
+      get<1>(liveRange[inst.getOperand(2)]) = count;
+    }
     count += 1;
   }
 }
@@ -279,6 +284,41 @@ string getRegisterName(int reg)
   return "";
 }
 
+// low byte of a register, what setcc writes
+string getByteRegisterName(int reg)
+{
+  string name = getRegisterName(reg);
+  return name.size() == 4 ? name.substr(0, 1) + name[2] + "l" : name;
+}
+
+// condition code suffix of a comparison, shared by jcc, setcc and cmovcc
+string getConditionCode(CmpInst::Predicate predicate)
+{
+  switch (predicate)
+  {
+  case CmpInst::ICMP_SGT:
+    return "g";
+  case CmpInst::ICMP_SLT:
+    return "l";
+  case CmpInst::ICMP_SGE:
+    return "ge";
+  case CmpInst::ICMP_SLE:
+    return "le";
+  case CmpInst::ICMP_UGT:
+    return "a";
+  case CmpInst::ICMP_ULT:
+    return "b";
+  case CmpInst::ICMP_UGE:
+    return "ae";
+  case CmpInst::ICMP_ULE:
+    return "be";
+  case CmpInst::ICMP_EQ:
+    return "e";
+  default:
+    return "ne";
+  }
+}
+
 void writeAsmFile(
     Module &module,
     string inputFileName,
@@ -439,6 +479,26 @@ void writeAsmFile(
             {
               asmFileStream << "\tjmp ." << bbLabels[op1] << endl;
             }
+            else if (!isa<ICmpInst>(op1))
+            {
+              // a condition computed earlier, e.g. loaded back from a temp, left no flags to branch on
+              BranchInst *branchInst = cast<BranchInst>(&inst);
+              if (ConstantInt *constCond = dyn_cast<ConstantInt>(op1))
+              {
+                asmFileStream << "\tjmp ." << bbLabels[branchInst->getSuccessor(constCond->isZero() ? 1 : 0)] << endl;
+                continue;
+              }
+              if (regMap.find(op1) != regMap.end() && regMap[op1] != -1)
+              {
+                asmFileStream << "\t" << acmp << " " << intLit << "0, " << getRegisterName(regMap[op1]) << endl;
+              }
+              else
+              {
+                asmFileStream << "\t" << acmp << " " << intLit << "0, " << offsetMap[op1] << "(" << basePointer << ")" << endl;
+              }
+              asmFileStream << "\tjne ." << bbLabels[branchInst->getSuccessor(0)] << endl
+                            << "\tjmp ." << bbLabels[branchInst->getSuccessor(1)] << endl;
+            }
             else if (inst.getNumOperands() >= 3)
             {
               op3 = inst.getOperand(2);
@@ -469,6 +529,130 @@ void writeAsmFile(
               asmFileStream << "jmp ." << bbLabels[op3] << endl;
             }
           }
+          else if (opCode == Instruction::Switch)
+          {
+            SwitchInst *switchInst = cast<SwitchInst>(&inst);
+            ConstantInt *constOp = dyn_cast<ConstantInt>(op1);
+            if (constOp != nullptr)
+            {
+              asmFileStream << "\t" << amov << " " << intLit << constOp->getSExtValue() << ", " << getRegisterName(EAX) << endl;
+            }
+            else if (regMap.find(op1) != regMap.end() && regMap[op1] != -1)
+            {
+              asmFileStream << "\t" << amov << " " << getRegisterName(regMap[op1]) << ", " << getRegisterName(EAX) << endl;
+            }
+            else
+            {
+              asmFileStream << "\t" << amov << " " << offsetMap[op1] << "(" << basePointer << "), " << getRegisterName(EAX) << endl;
+            }
+            string defaultLabel = bbLabels[switchInst->getDefaultDest()];
+            vector<pair<int64_t, string>> cases;
+            for (auto &switchCase : switchInst->cases())
+            {
+              cases.push_back(make_pair(switchCase.getCaseValue()->getSExtValue(), bbLabels[switchCase.getCaseSuccessor()]));
+            }
+            std::sort(cases.begin(), cases.end());
+            int64_t range = cases.empty() ? 0 : cases.back().first - cases.front().first + 1;
+            if (cases.empty())
+            {
+              // a switch left with no cases always takes its default
+              asmFileStream << "\tjmp ." << defaultLabel << endl;
+            }
+            else if (cases.size() >= JUMP_TABLE_MIN_CASES && range <= JUMP_TABLE_MAX_SPREAD * (int64_t)cases.size())
+            {
+              // dense cases index a table of block addresses, values outside it wrap above its size
+              string table = "." + bbLabels[&block] + "_table";
+              asmFileStream << "\t" << asub << " " << intLit << cases.front().first << ", " << getRegisterName(EAX) << endl
+                            << "\t" << acmp << " " << intLit << range - 1 << ", " << getRegisterName(EAX) << endl
+                            << "\tja ." << defaultLabel << endl
+                            << "\tjmp *" << table << "(," << getRegisterName(EAX) << ",4)" << endl
+                            << "\t.section .rodata" << endl
+                            << "\t.align 4" << endl
+                            << table << ":" << endl;
+              size_t next = 0;
+              for (int64_t value = cases.front().first; value <= cases.back().first; value++)
+              {
+                bool hit = cases[next].first == value;
+                asmFileStream << "\t.long ." << (hit ? cases[next].second : defaultLabel) << endl;
+                next += hit;
+              }
+              asmFileStream << "\t.text" << endl;
+            }
+            else
+            {
+              // sparse cases are found by binary search over the sorted values
+              int searchLabels = 0;
+              std::function<void(size_t, size_t)> search = [&](size_t low, size_t high)
+              {
+                if (high - low <= 3)
+                {
+                  for (size_t index = low; index < high; index++)
+                  {
+                    asmFileStream << "\t" << acmp << " " << intLit << cases[index].first << ", " << getRegisterName(EAX) << endl
+                                  << "\tje ." << cases[index].second << endl;
+                  }
+                  asmFileStream << "\tjmp ." << defaultLabel << endl;
+                  return;
+                }
+                size_t middle = (low + high) / 2;
+                string upper = "." + bbLabels[&block] + "_s" + to_string(searchLabels++);
+                asmFileStream << "\t" << acmp << " " << intLit << cases[middle].first << ", " << getRegisterName(EAX) << endl
+                              << "\tjge " << upper << endl;
+                search(low, middle);
+                asmFileStream << upper << ":" << endl;
+                search(middle, high);
+              };
+              search(0, cases.size());
+            }
+          }
+          else if (opCode == Instruction::Select)
+          {
+            SelectInst *selectInst = cast<SelectInst>(&inst);
+            auto operandString = [&](Value *val)
+            {
+              ConstantInt *constOp = dyn_cast<ConstantInt>(val);
+              if (constOp != nullptr)
+              {
+                return intLit + to_string(constOp->getSExtValue());
+              }
+              if (regMap.find(val) != regMap.end() && regMap[val] != -1)
+              {
+                return getRegisterName(regMap[val]);
+              }
+              return to_string(offsetMap[val]) + "(" + basePointer + ")";
+            };
+            ConstantInt *constCond = dyn_cast<ConstantInt>(selectInst->getCondition());
+            if (constCond != nullptr)
+            {
+              Value *chosen = constCond->isZero() ? selectInst->getFalseValue() : selectInst->getTrueValue();
+              asmFileStream << "\t" << amov << " " << operandString(chosen) << ", " << getRegisterName(EAX) << endl;
+            }
+            else
+            {
+              // the false value goes in unconditionally, cmov replaces it with the true one without a branch
+              asmFileStream << "\t" << acmp << " " << intLit << "0, " << operandString(selectInst->getCondition()) << endl
+                            << "\t" << amov << " " << operandString(selectInst->getFalseValue()) << ", " << getRegisterName(EAX) << endl;
+              if (isa<ConstantInt>(selectInst->getTrueValue()))
+              {
+                // cmov takes no immediate, so the constant is read back from the stack
+                asmFileStream << "\t" << apush << " " << operandString(selectInst->getTrueValue()) << endl
+                              << "\tcmovne (" << stackPointer << "), " << getRegisterName(EAX) << endl
+                              << "\t" << aadd << " " << intLit << "4, " << stackPointer << endl;
+              }
+              else
+              {
+                asmFileStream << "\tcmovne " << operandString(selectInst->getTrueValue()) << ", " << getRegisterName(EAX) << endl;
+              }
+            }
+            if (regMap.find(&inst) != regMap.end() && regMap[&inst] != -1)
+            {
+              asmFileStream << "\t" << amov << " " << getRegisterName(EAX) << ", " << getRegisterName(regMap[&inst]) << endl;
+            }
+            else
+            {
+              asmFileStream << "\t" << amov << " " << getRegisterName(EAX) << ", " << offsetMap[&inst] << "(" << basePointer << ")" << endl;
+            }
+          }
           else if (opCode == Instruction::Add ||
                    opCode == Instruction::Sub ||
                    opCode == Instruction::Mul ||
@@ -512,6 +696,13 @@ void writeAsmFile(
               asmFileStream << "\t" << (opCode == Instruction::Add ? aadd : (opCode == Instruction::Sub ? asub : (opCode == Instruction::Mul ? amul : (acmp))))
                             << " " << offsetMap[op2] << "(" << basePointer << "), " << getRegisterName(instReg) << endl;
             }
+            // a comparison read as a value, not just by the branch after it, becomes 0 or 1; neither move touches the flags
+            if (opCode == Instruction::ICmp && any_of(inst.users(), [](User *user)
+                                                      { return !isa<BranchInst>(user); }))
+            {
+              asmFileStream << "\tset" << getConditionCode(cast<ICmpInst>(inst).getPredicate()) << " " << getByteRegisterName(instReg) << endl
+                            << "\tmovzbl " << getByteRegisterName(instReg) << ", " << getRegisterName(instReg) << endl;
+            }
             if (inMemory)
             {
               int instOffset = offsetMap[&inst];
@@ -575,12 +766,14 @@ void codeGen(Module &module, string inputFileName, string asmFile)
         {
           op2 = inst.getOperand(1);
         }
+        Value *op3 = opCode == Instruction::Select ? inst.getOperand(2) : nullptr;
         switch (opCode)
         {
         case Instruction::Alloca:
           break;
         case Instruction::Store:
         case Instruction::Br:
+        case Instruction::Switch:
           freeRegister(op1, &inst, availablePhysRegs, liveRange, instIdx, regMap);
           freeRegister(op2, &inst, availablePhysRegs, liveRange, instIdx, regMap);
           break;
@@ -618,6 +811,7 @@ void codeGen(Module &module, string inputFileName, string asmFile)
             availablePhysRegs.erase(physReg);
             freeRegister(op1, &inst, availablePhysRegs, liveRange, instIdx, regMap);
             freeRegister(op2, &inst, availablePhysRegs, liveRange, instIdx, regMap);
+            freeRegister(op3, &inst, availablePhysRegs, liveRange, instIdx, regMap);
           }
           else
           {
@@ -638,6 +832,7 @@ void codeGen(Module &module, string inputFileName, string asmFile)
             }
             freeRegister(op1, &inst, availablePhysRegs, liveRange, instIdx, regMap);
             freeRegister(op2, &inst, availablePhysRegs, liveRange, instIdx, regMap);
+            freeRegister(op3, &inst, availablePhysRegs, liveRange, instIdx, regMap);
           }
           break;
         }
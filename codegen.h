@@ -19,6 +19,7 @@
 #define _CODE_GEN_
 
 #include <algorithm>
+#include <functional>
 #include "optimizer.h"
 
 using namespace std;
@@ -32,6 +33,10 @@ enum REG_VALS
   EAX = 3,
 };
 
+// fewest cases a switch lowers to a jump table with, and how many table slots each case may cost
+#define JUMP_TABLE_MIN_CASES 4
+#define JUMP_TABLE_MAX_SPREAD 3
+
 typedef enum
 {
   EMIT_FUNCTION_DIRECTIVE = 0,
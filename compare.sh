@@ -0,0 +1,64 @@
+#!/bin/bash
+# compiles every test program with our optimizer and with llvm's O2 pipeline,
+# checks both, and ours guided by a profile of the program, print the same as the unoptimized -O0 build and reports instructions, blocks and runtime side by side
+# usage: ./compare.sh [input fed to the programs] [runs per timing]
+
+INPUT=${1:-4}
+RUNS=${2:-20}
+OUT=compare_out
+mkdir -p $OUT
+
+instructions()
+{
+	awk '/^define/ { body = 1; next } /^}/ { body = 0 } body && /^  [^ ]/ { n++ } END { print n + 0 }' $1
+}
+
+blocks()
+{
+	awk '/^define/ { n++ } /^[0-9A-Za-z_.]+:/ { n++ } END { print n + 0 }' $1
+}
+
+# total wall-clock milliseconds for RUNS runs
+runtime()
+{
+	start=$(date +%s%N)
+	for ((run = 0; run < RUNS; run++)); do
+		echo $INPUT | ./$1 > /dev/null
+	done
+	echo $((($(date +%s%N) - start) / 1000000))
+}
+
+status=0
+printf "%-16s %12s %12s %12s %12s %12s %12s  %s\n" test "insts" "llvm insts" blocks "llvm blocks" "ms" "llvm ms" output
+for test in semantic_tests/*.c test_llvm/*.c; do
+	name=$(basename $test .c)
+	# programs the front end rejects have nothing to compare, once llvm's build succeeds ours must too
+	./pset.out $test $OUT/$name.llvm -O2 --passes=llvm > /dev/null 2>&1 || continue
+	if ! ./pset.out $test $OUT/$name.custom -O2 --passes=custom > /dev/null 2>&1 ||
+		! ./pset.out $test $OUT/$name.O0 -O0 > /dev/null 2>&1; then
+		echo "$name: optimizer failed"
+		status=1
+		continue
+	fi
+	gcc -m64 main.c $OUT/$name.custom.s -o $OUT/$name.custom.out || { status=1; continue; }
+	gcc -m64 main.c $OUT/$name.llvm.s -o $OUT/$name.llvm.out || { status=1; continue; }
+	gcc -m64 main.c $OUT/$name.O0.s -o $OUT/$name.O0.out || { status=1; continue; }
+	# a profile from an instrumented run drives block layout and unrolling in one more build of ours
+	./pset.out $test $OUT/$name.instrumented -O2 --instrument > /dev/null 2>&1 &&
+		gcc -m64 main.c $OUT/$name.instrumented.s -o $OUT/$name.instrumented.out &&
+		echo $INPUT | MINIC_PROFILE=$OUT/$name.profile ./$OUT/$name.instrumented.out > /dev/null &&
+		./pset.out $test $OUT/$name.pgo -O2 --passes=custom --profile-use=$OUT/$name.profile > /dev/null 2>&1 &&
+		gcc -m64 main.c $OUT/$name.pgo.s -o $OUT/$name.pgo.out || { echo "$name: profile-guided build failed"; status=1; continue; }
+	output=same
+	expected="$(echo $INPUT | ./$OUT/$name.O0.out)"
+	if [ "$(echo $INPUT | ./$OUT/$name.custom.out)" != "$expected" ] || [ "$(echo $INPUT | ./$OUT/$name.llvm.out)" != "$expected" ] ||
+		[ "$(echo $INPUT | ./$OUT/$name.pgo.out)" != "$expected" ]; then
+		output=DIFFERENT
+		status=1
+	fi
+	printf "%-16s %12s %12s %12s %12s %12s %12s  %s\n" $name \
+		$(instructions $OUT/$name.custom.ll) $(instructions $OUT/$name.llvm.ll) \
+		$(blocks $OUT/$name.custom.ll) $(blocks $OUT/$name.llvm.ll) \
+		$(runtime $OUT/$name.custom.out) $(runtime $OUT/$name.llvm.out) $output
+done
+exit $status
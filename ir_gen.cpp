@@ -176,7 +176,101 @@ Value *parseExpression(IRBuilder<> &builder,
 	return nullptr;
 }
 
-void generateIR(astNode *iNode, string input, string output)
+// conditional branches in layout order, the order profile counters are numbered in
+vector<BranchInst *> getConditionalBranches(Function *llvmFunc)
+{
+	vector<BranchInst *> branches;
+	for (BasicBlock &block : *llvmFunc)
+	{
+		BranchInst *br = dyn_cast<BranchInst>(block.getTerminator());
+		if (br != nullptr && br->isConditional())
+		{
+			branches.push_back(br);
+		}
+	}
+	return branches;
+}
+
+// a taken and a not-taken counter per conditional branch, handed to the runtime which writes them at exit
+void instrumentBranches(Function *llvmFunc, Module *module)
+{
+	vector<BranchInst *> branches = getConditionalBranches(llvmFunc);
+	if (branches.empty())
+	{
+		return;
+	}
+	IRBuilder<> builder(module->getContext());
+	ArrayType *countersType = ArrayType::get(builder.getInt64Ty(), branches.size() * 2);
+	GlobalVariable *counters = new GlobalVariable(*module, countersType, false, GlobalValue::InternalLinkage,
+																								ConstantAggregateZero::get(countersType), "profile.counters");
+	FunctionCallee registerFunc = module->getOrInsertFunction(ARM_FUNC_PRE + "minicProfileRegister", builder.getVoidTy(),
+																														 builder.getInt64Ty()->getPointerTo(), builder.getInt32Ty());
+	builder.SetInsertPoint(llvmFunc->getEntryBlock().getTerminator());
+	builder.CreateCall(registerFunc, {builder.CreateConstInBoundsGEP2_64(countersType, counters, 0, 0),
+																		builder.getInt32(branches.size() * 2)});
+	for (unsigned k = 0; k < branches.size(); k++)
+	{
+		builder.SetInsertPoint(branches[k]);
+		Value *taken = builder.CreateZExt(branches[k]->getCondition(), builder.getInt64Ty());
+		Value *counts[2] = {taken, builder.CreateSub(builder.getInt64(1), taken)};
+		for (unsigned edge = 0; edge < 2; edge++)
+		{
+			Value *counter = builder.CreateConstInBoundsGEP2_64(countersType, counters, 0, 2 * k + edge);
+			builder.CreateStore(builder.CreateAdd(builder.CreateLoad(builder.getInt64Ty(), counter), counts[edge]), counter);
+		}
+	}
+}
+
+// branch weights from the profile of an instrumented run of the same program
+void applyProfile(Function *llvmFunc, string profile)
+{
+	vector<BranchInst *> branches = getConditionalBranches(llvmFunc);
+	if (branches.empty())
+	{
+		return;
+	}
+	ifstream file(profile);
+	string magic;
+	size_t size = 0;
+	vector<uint64_t> counts(branches.size() * 2);
+	file >> magic >> size;
+	for (uint64_t &count : counts)
+	{
+		file >> count;
+	}
+	if (!file || magic != "minic-profile" || size != counts.size())
+	{
+		cerr << "Ignoring profile " << profile << ", it does not match this program" << endl;
+		return;
+	}
+	MDBuilder weights(llvmFunc->getContext());
+	for (unsigned k = 0; k < branches.size(); k++)
+	{
+		uint32_t taken = min<uint64_t>(counts[2 * k], UINT32_MAX);
+		uint32_t notTaken = min<uint64_t>(counts[2 * k + 1], UINT32_MAX);
+		branches[k]->setMetadata(LLVMContext::MD_prof, weights.createBranchWeights(taken, notTaken));
+	}
+}
+
+// line of what a statement evaluates first, its condition or value when it has one
+int getStatementLine(astNode *node)
+{
+	switch (node->stmt.type)
+	{
+	case ast_while:
+		return node->stmt.whilen.cond->line;
+	case ast_if:
+		return node->stmt.ifn.cond->line;
+	case ast_asgn:
+		return node->stmt.asgn.rhs->line;
+	case ast_ret:
+		return node->stmt.ret.expr != nullptr ? node->stmt.ret.expr->line : node->line;
+	default:
+		return node->line;
+	}
+}
+
+void generateIR(astNode *iNode, string input, string output, optimizerOptions options)
 {
 	if (iNode->type != ast_prog)
 	{
@@ -211,6 +305,22 @@ void generateIR(astNode *iNode, string input, string output)
 	FunctionType *funcType = FunctionType::get(retType, argTypes, false);
 	Function *llvmFunc = Function::Create(funcType, Function::ExternalLinkage, ARM_FUNC_PRE+string{func.name}, module);
 	functionMap[ARM_FUNC_PRE+string{func.name}] = llvmFunc;
+
+	// line tables so optimization remarks can name source lines
+	DIBuilder *debugInfo = nullptr;
+	DISubprogram *subprogram = nullptr;
+	if (!options.remarks.empty())
+	{
+		debugInfo = new DIBuilder(*module);
+		DIFile *file = debugInfo->createFile(input, ".");
+		debugInfo->createCompileUnit(dwarf::DW_LANG_C, file, "minic", options.level > 0, "", 0, "", DICompileUnit::LineTablesOnly);
+		DISubroutineType *subroutineType = debugInfo->createSubroutineType(debugInfo->getOrCreateTypeArray({}));
+		subprogram = debugInfo->createFunction(file, func.name, "", file, prog.func->line, subroutineType, prog.func->line,
+																					 DINode::FlagZero, DISubprogram::SPFlagDefinition);
+		llvmFunc->setSubprogram(subprogram);
+		module->addModuleFlag(Module::Warning, "Debug Info Version", DEBUG_METADATA_VERSION);
+		builder.SetCurrentDebugLocation(DILocation::get(context, prog.func->line, 0, subprogram));
+	}
 	vector<astNode *> nodeStack{func.body};
 	for (astNode *ext : *prog.exts)
 	{
@@ -233,6 +343,10 @@ void generateIR(astNode *iNode, string input, string output)
 			{
 				continue;
 			}
+			if (subprogram != nullptr && node->type == ast_stmt && node->stmt.type != ast_block)
+			{
+				builder.SetCurrentDebugLocation(DILocation::get(context, getStatementLine(node), 0, subprogram));
+			}
 			switch (node->type)
 			{
 			case ast_extern:
@@ -246,6 +360,13 @@ void generateIR(astNode *iNode, string input, string output)
 				Type *extRetType = getType(node->ext.type, builder);
 				FunctionType *extType = FunctionType::get(extRetType, extArgTypes, false);
 				Function *extFunc = Function::Create(extType, Function::ExternalLinkage, ARM_FUNC_PRE+name, module);
+				if (node->ext.pure)
+				{
+					// calls only compute their result, so the optimizer may merge, drop or hoist them
+					extFunc->addFnAttr(Attribute::ReadNone);
+					extFunc->addFnAttr(Attribute::WillReturn);
+					extFunc->addFnAttr(Attribute::NoUnwind);
+				}
 				functionMap[ARM_FUNC_PRE+name] = extFunc;
 				break;
 			}
@@ -469,8 +590,24 @@ void generateIR(astNode *iNode, string input, string output)
 		block->eraseFromParent();
 	}
 
+	// profile-guided optimization, counters and weights follow the unoptimized branches
+	if (options.instrument)
+	{
+		instrumentBranches(llvmFunc, module);
+	}
+	else if (!options.profile.empty())
+	{
+		applyProfile(llvmFunc, options.profile);
+	}
+
+	if (debugInfo != nullptr)
+	{
+		debugInfo->finalize();
+		delete debugInfo;
+	}
+
 	// optimize module
-	optimizeModule(*module);
+	optimizeModule(*module, options);
 
 	// write optimized ll file
 	ofstream ofs(output + ".ll");
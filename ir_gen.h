@@ -14,12 +14,13 @@
 
 #include <string>
 #include <iostream>
+#include <llvm/IR/DIBuilder.h>
 #include "ast.h"
 #include "optimizer.h"
 #include "codegen.h"
 
 using namespace std;
 
-void generateIR(astNode *iNode, string input, string output);
+void generateIR(astNode *iNode, string input, string output, optimizerOptions options);
 
 #endif
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 
 int func(int i);
 void print(char i)
@@ -25,6 +26,42 @@ char readc()
 	return c;
 }
 
+// no side effects and returns for every argument, programs may declare it extern pure
+int square(int i)
+{
+	return i * i;
+}
+
+// branch counters of a program compiled with --instrument, written at exit to $MINIC_PROFILE
+long long *profileCounters = NULL;
+int profileSize = 0;
+
+void writeProfile()
+{
+	const char *path = getenv("MINIC_PROFILE");
+	FILE *file = fopen(path != NULL ? path : "minic.profile", "w");
+	if (file == NULL)
+	{
+		return;
+	}
+	fprintf(file, "minic-profile %d\n", profileSize);
+	for (int i = 0; i < profileSize; i += 2)
+	{
+		fprintf(file, "%lld %lld\n", profileCounters[i], profileCounters[i + 1]);
+	}
+	fclose(file);
+}
+
+void minicProfileRegister(long long *counters, int size)
+{
+	if (profileCounters == NULL)
+	{
+		profileCounters = counters;
+		profileSize = size;
+		atexit(writeProfile);
+	}
+}
+
 int main()
 {
 	int i = func(3);
@@ -4,8 +4,25 @@
  * @brief optimizer with LLVM
  * constant folding
  * common sub-expression
+ * partial redundancy elimination
  * dead code
  * constant propagation
+ * algebraic simplification
+ * reassociation
+ * sparse conditional constant propagation
+ * value-range analysis
+ * dead store elimination
+ * control-flow simplification
+ * if-chain to switch conversion
+ * jump threading
+ * loop-invariant code motion
+ * loop unswitching
+ * if-conversion to selects
+ * code sinking and store merging
+ * induction-variable strength reduction
+ * loop unrolling
+ * loop rotation
+ * profile-guided block layout
  *
  * @version 0.1
  * @date 2023-05-04
@@ -19,33 +36,83 @@
 using namespace std;
 using namespace llvm;
 
-inline void log(string s)
-{
 #ifdef LOG
-  cout << s << endl;
+bool traceEnabled = true;
+#else
+bool traceEnabled = false;
 #endif
+
+// pass -> counter -> value
+map<string, map<string, uint64_t>> statistics;
+
+// heap allocations by the passes' own containers, sampled around each pass for the statistics
+uint64_t allocationCount = 0;
+
+// set while remarks are written, so their messages are only built when wanted
+bool remarksEnabled = false;
+
+// missed remarks already written, passes rerun every fixpoint iteration
+set<tuple<string, string, unsigned, string>> missedRemarks;
+
+// nearest source line to at: its own, an earlier instruction's in its block, or the function's
+DiagnosticLocation getRemarkLocation(Instruction *at)
+{
+	for (Instruction *inst = at; inst != nullptr; inst = inst->getPrevNode())
+	{
+		if (inst->getDebugLoc())
+		{
+			return DiagnosticLocation(inst->getDebugLoc());
+		}
+	}
+	return DiagnosticLocation(at->getFunction()->getSubprogram());
+}
+
+// count an event for the pass statistics, the trace message is only built when tracing, the remark when writing them
+template <typename Message>
+inline void log(const char *pass, const char *counter, Message message, Instruction *at = nullptr)
+{
+	statistics[pass][counter]++;
+	if (traceEnabled)
+	{
+		cout << message() << endl;
+	}
+	if (remarksEnabled && at != nullptr)
+	{
+		at->getContext().diagnose(OptimizationRemark(pass, counter, getRemarkLocation(at), at->getParent()) << message());
+	}
+}
+
+// a transformation a pass considered but could not make, and why
+template <typename Message>
+inline void missed(const char *pass, const char *name, Instruction *at, Message message)
+{
+	if (!remarksEnabled)
+	{
+		return;
+	}
+	string text = message();
+	DiagnosticLocation location = getRemarkLocation(at);
+	if (missedRemarks.insert(make_tuple(string{pass}, string{name}, location.getLine(), text)).second)
+	{
+		at->getContext().diagnose(OptimizationRemarkMissed(pass, name, location, at->getParent()) << text);
+	}
 }
 
-void generateKillGen(set<Instruction *> &gen,
-										 set<Instruction *> &kill,
-										 map<Value *, set<Value *> *> &store,
+// gen is the last store to each address in the block, kill every store to an address it writes
+void generateKillGen(BitVector &gen,
+										 BitVector &kill,
+										 DenseMap<Value *, BitVector> &storesTo,
+										 DenseMap<Instruction *, unsigned> &storeNumber,
 										 BasicBlock &block)
 {
 	for (Instruction &inst : block)
 	{
-		unsigned opCode = inst.getOpcode();
-		if (opCode == Instruction::Store)
+		if (StoreInst *store = dyn_cast<StoreInst>(&inst))
 		{
-			gen.insert(&inst);
-			Value *op1 = inst.getOperand(0);
-			Value *op2 = inst.getOperand(1);
-			if (store[op2] != nullptr)
-			{
-				set<Value *> *killed = store[op2];
-				killed->insert(killed->begin(), killed->end());
-			}
-			store[op2] = new set<Value *>();
-			store[op2]->insert(&inst);
+			BitVector &sameAddress = storesTo[store->getPointerOperand()];
+			gen.reset(sameAddress);
+			gen.set(storeNumber[store]);
+			kill |= sameAddress;
 		}
 	}
 }
@@ -57,95 +124,129 @@ string getInstructionString(Instruction &inst)
 	return instStr;
 }
 
+// allocas whose address is only ever loaded from or stored to
+bool isTrackedAlloca(Value *val)
+{
+	AllocaInst *alloca = dyn_cast<AllocaInst>(val);
+	if (alloca == nullptr || !alloca->getAllocatedType()->isIntegerTy())
+	{
+		return false;
+	}
+	for (User *user : alloca->users())
+	{
+		if (isa<LoadInst>(user))
+		{
+			continue;
+		}
+		StoreInst *storeInst = dyn_cast<StoreInst>(user);
+		if (storeInst == nullptr || storeInst->getValueOperand() == alloca)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// calls to externs declared pure: no memory access, no unwinding, always return
+bool isPureCall(Instruction &inst)
+{
+	CallInst *call = dyn_cast<CallInst>(&inst);
+	return call != nullptr && call->doesNotAccessMemory() && call->doesNotThrow() && call->hasFnAttr(Attribute::WillReturn);
+}
+
+// (opcode and predicate, type, operands)
+typedef tuple<unsigned, Type *, Value *, Value *> expressionKey;
+
 void eliminateCommonSubExpression(BasicBlock &basicBlock, bool &change)
 {
-	map<pair<Value *, Value *>, pair<unsigned, Instruction *> *> commonSubexpressions;
-	map<Value *, vector<pair<Value *, Value *>> *> opTrace;
+	DenseMap<expressionKey, Instruction *> commonSubexpressions;
+	// pure calls by callee and arguments
+	passMap<passVector<Value *>, Instruction *> pureCalls;
+	// last value loaded from or stored to each address
+	DenseMap<Value *, Value *> availableLoads;
 
 	for (Instruction &inst : basicBlock)
 	{
-		unsigned opCode = inst.getOpcode();
-		if (inst.getNumOperands() == 0)
+		if (StoreInst *store = dyn_cast<StoreInst>(&inst))
 		{
+			if (isTrackedAlloca(store->getPointerOperand()))
+			{
+				availableLoads[store->getPointerOperand()] = store->getValueOperand();
+			}
+			else
+			{
+				availableLoads.erase(store->getPointerOperand());
+			}
 			continue;
 		}
-		Value *op1 = inst.getOperand(0);
-		Value *op2 = nullptr;
-
-		if (inst.getNumOperands() > 1)
+		Value *available = nullptr;
+		if (LoadInst *load = dyn_cast<LoadInst>(&inst))
 		{
-			op2 = inst.getOperand(1);
+			auto inserted = availableLoads.try_emplace(load->getPointerOperand(), load);
+			if (!inserted.second && inserted.first->second->getType() == load->getType())
+			{
+				available = inserted.first->second;
+			}
 		}
-		switch (opCode)
+		else if (isa<BinaryOperator>(inst) || isa<CmpInst>(inst) || isa<CastInst>(inst))
 		{
-		case Instruction::Store:
-			if (opTrace[op2] != nullptr)
+			unsigned opCode = inst.getOpcode() << 8;
+			if (CmpInst *cmp = dyn_cast<CmpInst>(&inst))
 			{
-				for (auto &p : *(opTrace[op2]))
-				{
-					delete commonSubexpressions[p];
-					commonSubexpressions.erase(p);
-				}
-				delete opTrace[op2];
-				opTrace.erase(op2);
+				opCode |= cmp->getPredicate();
 			}
-			break;
-		case Instruction::Alloca:
-		case Instruction::Br:
-		case Instruction::Call:
-			break;
-		default:
-			Value *op2Ref = op2 != nullptr ? op2 : op1;
-			pair<Value *, Value *> operands = make_pair(max(op1, op2Ref), min(op1, op2Ref));
-			pair<unsigned, Instruction *> *subExpr = commonSubexpressions[operands];
-			if (subExpr != nullptr && subExpr->first == opCode)
+			Value *op1 = inst.getOperand(0);
+			Value *op2 = inst.getNumOperands() > 1 ? inst.getOperand(1) : nullptr;
+			if (inst.isCommutative() && op1 < op2)
 			{
-				log(string{"CSE -> "} + getInstructionString(inst));
-				inst.replaceAllUsesWith(subExpr->second);
-				change = true;
+				swap(op1, op2);
 			}
-			else
+			auto inserted = commonSubexpressions.try_emplace(expressionKey{opCode, inst.getType(), op1, op2}, &inst);
+			if (!inserted.second)
 			{
-				commonSubexpressions[operands] = new pair<unsigned, Instruction *>(opCode, &inst);
-				if (opTrace[op1] == nullptr)
-				{
-					opTrace[op1] = new vector<pair<Value *, Value *>>();
-				}
-				opTrace[op1]->push_back(operands);
-				if (op2 != NULL)
-				{
-					if (opTrace[op2] == nullptr)
-					{
-						opTrace[op2] = new vector<pair<Value *, Value *>>();
-					}
-					opTrace[op2]->push_back(operands);
-				}
+				available = inserted.first->second;
 			}
-			break;
+		}
+		else if (isPureCall(inst))
+		{
+			auto inserted = pureCalls.try_emplace(passVector<Value *>(inst.op_begin(), inst.op_end()), &inst);
+			if (!inserted.second)
+			{
+				available = inserted.first->second;
+			}
+		}
+		if (available != nullptr)
+		{
+			log("minic-cse", "eliminated", [&]
+					{ return string{"CSE -> "} + getInstructionString(inst); }, &inst);
+			inst.replaceAllUsesWith(available);
+			change = true;
 		}
 	}
 }
 
 void eliminateDeadCode(BasicBlock &basicBlock, bool &change)
 {
-	set<Instruction *> toErase;
+	SmallVector<Instruction *, 16> toErase;
 	for (Instruction &inst : basicBlock)
 	{
 		unsigned opCode = inst.getOpcode();
 		bool check = (opCode != Instruction::Store &&
 									opCode != Instruction::Alloca &&
 									opCode != Instruction::Br &&
-									opCode != Instruction::Call &&
+									opCode != Instruction::Switch &&
+									(opCode != Instruction::Call || isPureCall(inst)) &&
 									opCode != Instruction::Ret);
 		if (inst.hasNUses(0) && check)
 		{
-			toErase.insert(&inst);
+			toErase.push_back(&inst);
 			change = true;
 		}
 	}
 	for (Instruction *inst : toErase)
 	{
-		log(string{"DE -> "} + getInstructionString(*inst));
+		log("minic-dce", "eliminated", [&]
+				{ return string{"DE -> "} + getInstructionString(*inst); }, inst);
 		inst->eraseFromParent();
 	}
 }
@@ -174,7 +275,6 @@ void constantFolding(BasicBlock &basicBlock, bool &change)
 		CmpInst::Predicate predicate;
 		if (const1 && const2)
 		{
-			log(string{"CF  -> "} + getInstructionString(inst));
 			Constant *newInstruction = nullptr;
 			switch (opCode)
 			{
@@ -187,6 +287,12 @@ void constantFolding(BasicBlock &basicBlock, bool &change)
 			case Instruction::Mul:
 				newInstruction = ConstantExpr::getMul(const1, const2);
 				break;
+			case Instruction::SDiv:
+				if (!const2->isZero() && !(const2->isMinusOne() && const1->isMinValue(true)))
+				{
+					newInstruction = ConstantInt::get(const1->getType(), const1->getValue().sdiv(const2->getValue()));
+				}
+				break;
 			case Instruction::ICmp:
 				predicate = cast<ICmpInst>(&inst)->getPredicate();
 				newInstruction = ConstantExpr::getICmp(predicate, const1, const2);
@@ -196,6 +302,8 @@ void constantFolding(BasicBlock &basicBlock, bool &change)
 			}
 			if (newInstruction)
 			{
+				log("minic-constfold", "folded", [&]
+						{ return string{"CF  -> "} + getInstructionString(inst); }, &inst);
 				inst.replaceAllUsesWith(newInstruction);
 				change = true;
 			}
@@ -203,122 +311,3772 @@ void constantFolding(BasicBlock &basicBlock, bool &change)
 	}
 }
 
-void constantPropagation(Function &func, bool &change)
+// magic multiplier and shift for signed division by a constant (Hacker's Delight 10-1)
+void signedDivisionMagic(int64_t divisor, unsigned width, int64_t &magic, unsigned &shift)
 {
-	map<BasicBlock *, set<Instruction *>> kill, gen, ins, outs;
-	map<Value *, set<Value *> *> store;
+	uint64_t mask = (uint64_t{1} << width) - 1;
+	uint64_t signBit = uint64_t{1} << (width - 1);
+	uint64_t ad = (uint64_t)(divisor < 0 ? -divisor : divisor);
+	uint64_t t = signBit + (((uint64_t)divisor & mask) >> (width - 1));
+	uint64_t anc = t - 1 - t % ad;
+	unsigned p = width - 1;
+	uint64_t q1 = signBit / anc;
+	uint64_t r1 = signBit - q1 * anc;
+	uint64_t q2 = signBit / ad;
+	uint64_t r2 = signBit - q2 * ad;
+	uint64_t delta;
+	do
+	{
+		p++;
+		q1 = (2 * q1) & mask;
+		r1 = (2 * r1) & mask;
+		if (r1 >= anc)
+		{
+			q1 = (q1 + 1) & mask;
+			r1 = (r1 - anc) & mask;
+		}
+		q2 = (2 * q2) & mask;
+		r2 = (2 * r2) & mask;
+		if (r2 >= ad)
+		{
+			q2 = (q2 + 1) & mask;
+			r2 = (r2 - ad) & mask;
+		}
+		delta = (ad - r2) & mask;
+	} while (q1 < delta || (q1 == delta && r1 == 0));
+	uint64_t m = (q2 + 1) & mask;
+	if (divisor < 0)
+	{
+		m = (0 - m) & mask;
+	}
+	magic = (m & signBit) ? (int64_t)(m | ~mask) : (int64_t)m;
+	shift = p - width;
+}
 
-	// generate kill gen
-	for (BasicBlock &block : func)
+// n / d as a multiply-high and shifts, d not in {-1, 0, 1}
+Value *createSignedDivision(IRBuilder<> &builder, Value *n, int64_t divisor)
+{
+	IntegerType *type = cast<IntegerType>(n->getType());
+	unsigned width = type->getBitWidth();
+	uint64_t absDivisor = (uint64_t)(divisor < 0 ? -divisor : divisor);
+	Value *quotient = nullptr;
+	if (isPowerOf2_64(absDivisor))
 	{
-		generateKillGen(gen[&block], kill[&block], store, block);
-		outs[&block] = gen[&block];
+		// bias negative dividends by d - 1 so the shift rounds toward zero
+		unsigned k = Log2_64(absDivisor);
+		Value *sign = builder.CreateAShr(n, width - 1);
+		Value *bias = builder.CreateLShr(sign, width - k);
+		quotient = builder.CreateAShr(builder.CreateAdd(n, bias), k);
+		return divisor < 0 ? builder.CreateNeg(quotient) : quotient;
 	}
-	for (BasicBlock &block : func)
+	int64_t magic;
+	unsigned shift;
+	signedDivisionMagic(divisor, width, magic, shift);
+	IntegerType *wideType = IntegerType::get(type->getContext(), width * 2);
+	Value *product = builder.CreateMul(builder.CreateSExt(n, wideType), ConstantInt::get(wideType, magic, true));
+	quotient = builder.CreateTrunc(builder.CreateAShr(product, width), type);
+	if (divisor > 0 && magic < 0)
 	{
-		bool tempChange = true;
-		do
-		{
-			tempChange = false;
-			// union of predecessor of block
-			for_each(
-					pred_begin(&block),
-					pred_end(&block),
-					[&ins, &outs, &block](BasicBlock *pred)
-					{
-						set<Instruction *> bOut = outs[pred];
-						ins[&block].insert(bOut.begin(), bOut.end());
-					});
+		quotient = builder.CreateAdd(quotient, n);
+	}
+	else if (divisor < 0 && magic > 0)
+	{
+		quotient = builder.CreateSub(quotient, n);
+	}
+	if (shift > 0)
+	{
+		quotient = builder.CreateAShr(quotient, shift);
+	}
+	return builder.CreateAdd(quotient, builder.CreateLShr(quotient, width - 1));
+}
 
-			// difference of in and kill
-			set<Instruction *> oldOut = outs[&block];
-			set<Instruction *> diff;
-			for (Instruction *inst : ins[&block])
+void combineInstructions(BasicBlock &basicBlock, bool &change)
+{
+	for (Instruction &inst : basicBlock)
+	{
+		// selects on a constant or between one value
+		if (SelectInst *select = dyn_cast<SelectInst>(&inst))
+		{
+			ConstantInt *cond = dyn_cast<ConstantInt>(select->getCondition());
+			Value *replacement = cond != nullptr ? (cond->isZero() ? select->getFalseValue() : select->getTrueValue())
+																					 : nullptr;
+			if (select->getTrueValue() == select->getFalseValue())
 			{
-				if (kill[&block].find(inst) == kill[&block].end())
-				{
-					diff.insert(inst);
-				}
+				replacement = select->getTrueValue();
 			}
+			if (replacement != nullptr && !inst.use_empty())
+			{
+				log("minic-combine", "simplified", [&]
+						{ return string{"IC  -> "} + getInstructionString(inst); }, &inst);
+				inst.replaceAllUsesWith(replacement);
+				change = true;
+			}
+			continue;
+		}
+		if (inst.use_empty() || inst.getNumOperands() != 2 || (!isa<BinaryOperator>(inst) && !isa<ICmpInst>(inst)))
+		{
+			continue;
+		}
+		Value *op1 = inst.getOperand(0);
+		Value *op2 = inst.getOperand(1);
 
-			// union(out, diff(in, kill))
-			outs[&block] = gen[&block];
-			outs[&block].insert(diff.begin(), diff.end());
+		// constants on the right
+		if (isa<ConstantInt>(op1) && !isa<ConstantInt>(op2))
+		{
+			if (ICmpInst *cmp = dyn_cast<ICmpInst>(&inst))
+			{
+				log("minic-combine", "canonicalized", [&]
+						{ return string{"IC  -> "} + getInstructionString(inst); }, &inst);
+				cmp->swapOperands();
+				swap(op1, op2);
+				change = true;
+			}
+			else if (inst.isCommutative())
+			{
+				log("minic-combine", "canonicalized", [&]
+						{ return string{"IC  -> "} + getInstructionString(inst); }, &inst);
+				cast<BinaryOperator>(inst).swapOperands();
+				swap(op1, op2);
+				change = true;
+			}
+		}
 
-			// diff(out, old_out)
-			if (outs[&block].size() != oldOut.size())
+		ConstantInt *const2 = dyn_cast<ConstantInt>(op2);
+		IRBuilder<> builder(&inst);
+		Value *replacement = nullptr;
+		switch (inst.getOpcode())
+		{
+		case Instruction::Add:
+			if (const2 && const2->isZero())
 			{
-				tempChange = true;
+				replacement = op1;
 			}
-			// break;
-		} while (tempChange);
+			break;
+		case Instruction::Sub:
+			if (const2 && const2->isZero())
+			{
+				replacement = op1;
+			}
+			else if (op1 == op2)
+			{
+				replacement = ConstantInt::get(inst.getType(), 0);
+			}
+			break;
+		case Instruction::Mul:
+			if (const2 == nullptr)
+			{
+				break;
+			}
+			if (const2->isZero() || const2->isOne())
+			{
+				replacement = const2->isZero() ? op2 : op1;
+			}
+			else if (const2->isMinusOne())
+			{
+				replacement = builder.CreateNeg(op1);
+			}
+			else if (const2->getValue().isPowerOf2())
+			{
+				replacement = builder.CreateShl(op1, const2->getValue().logBase2());
+			}
+			break;
+		case Instruction::Shl:
+		case Instruction::AShr:
+		case Instruction::LShr:
+			if (const2 && const2->isZero())
+			{
+				replacement = op1;
+			}
+			break;
+		case Instruction::SDiv:
+			if (const2 == nullptr || const2->isZero() || isa<ConstantInt>(op1) || inst.getType()->getIntegerBitWidth() > 32)
+			{
+				break;
+			}
+			if (const2->isOne())
+			{
+				replacement = op1;
+			}
+			else if (const2->isMinusOne())
+			{
+				replacement = builder.CreateNeg(op1);
+			}
+			else
+			{
+				replacement = createSignedDivision(builder, op1, const2->getSExtValue());
+			}
+			break;
+		case Instruction::ICmp:
+			if (op1 == op2)
+			{
+				replacement = ConstantInt::get(inst.getType(), ICmpInst::isTrueWhenEqual(cast<ICmpInst>(inst).getPredicate()));
+			}
+			break;
+		default:
+			break;
+		}
+		if (replacement != nullptr)
+		{
+			log("minic-combine", "simplified", [&]
+					{ return string{"IC  -> "} + getInstructionString(inst); }, &inst);
+			inst.replaceAllUsesWith(replacement);
+			change = true;
+		}
+	}
+}
+
+// operand that belongs to the tree it feeds: same opcode, same block, used only there
+bool isTreeInterior(Value *val, unsigned opCode, BasicBlock *block)
+{
+	BinaryOperator *binOp = dyn_cast<BinaryOperator>(val);
+	return binOp != nullptr && binOp->getOpcode() == opCode && binOp->getParent() == block && binOp->hasOneUse();
+}
+
+// leaves and interior nodes of the expression tree rooted at inst, returns its height
+unsigned collectTreeLeaves(Instruction *inst, SmallVectorImpl<Value *> &leaves, SmallVectorImpl<Instruction *> &interior)
+{
+	unsigned height = 0;
+	for (Value *op : inst->operands())
+	{
+		if (isTreeInterior(op, inst->getOpcode(), inst->getParent()))
+		{
+			interior.push_back(cast<Instruction>(op));
+			height = max(height, collectTreeLeaves(cast<Instruction>(op), leaves, interior));
+		}
+		else
+		{
+			leaves.push_back(op);
+		}
 	}
+	return height + 1;
+}
 
-	set<Instruction *> toErase;
+// regroup associative chains: constants folded together, the rest as a balanced tree by rank
+void reassociateExpressions(Function &func, bool &change)
+{
+	// rank values by when they become available, arguments then instructions in order
+	DenseMap<Value *, unsigned> rank;
+	unsigned nextRank = 1;
+	for (Argument &arg : func.args())
+	{
+		rank[&arg] = nextRank++;
+	}
+	SmallVector<BinaryOperator *, 16> roots;
 	for (BasicBlock &block : func)
 	{
-		set<Instruction *> R = ins[&block];
 		for (Instruction &inst : block)
 		{
-			unsigned opCode = inst.getOpcode();
-			if (opCode == Instruction::Store)
+			rank[&inst] = nextRank++;
+			BinaryOperator *binOp = dyn_cast<BinaryOperator>(&inst);
+			if (binOp == nullptr || !binOp->getType()->isIntegerTy() || !Instruction::isAssociative(binOp->getOpcode()))
+			{
+				continue;
+			}
+			User *user = binOp->hasOneUse() ? *binOp->user_begin() : nullptr;
+			if (user == nullptr || !isTreeInterior(binOp, cast<Instruction>(user)->getOpcode(), cast<Instruction>(user)->getParent()))
+			{
+				roots.push_back(binOp);
+			}
+		}
+	}
+
+	for (BinaryOperator *root : roots)
+	{
+		SmallVector<Value *, 8> leaves;
+		SmallVector<Instruction *, 8> interior;
+		unsigned height = collectTreeLeaves(root, leaves, interior);
+		Instruction::BinaryOps opCode = root->getOpcode();
+		Constant *folded = nullptr;
+		unsigned numConstants = 0;
+		SmallVector<Value *, 8> operands;
+		for (Value *leaf : leaves)
+		{
+			if (ConstantInt *constLeaf = dyn_cast<ConstantInt>(leaf))
 			{
-				erase_if(R, [&inst](Instruction *x)
-								 { return x->getOperand(1) == inst.getOperand(1); });
-				R.insert(&inst);
+				folded = folded == nullptr ? constLeaf : ConstantExpr::get(opCode, folded, constLeaf);
+				numConstants++;
 			}
-			if (opCode == Instruction::Load)
+			else
 			{
-				ConstantInt *constVal = nullptr;
-				bool replace{false};
+				operands.push_back(leaf);
+			}
+		}
+		unsigned balanced = (operands.size() > 1 ? Log2_32_Ceil(operands.size()) : 0) + (folded != nullptr ? 1 : 0);
+		if (numConstants < 2 && height <= balanced)
+		{
+			continue;
+		}
+		log("minic-reassociate", "reassociated", [&]
+				{ return string{"RA  -> "} + getInstructionString(*root); }, root);
 
-				for_each(R,
-								 [&inst, &constVal, &replace](Instruction *x)
-								 {
-									 ConstantInt *constOp = dyn_cast<ConstantInt>(x->getOperand(0));
-									 if (constOp != nullptr)
-									 {
-										 if (
-												 constVal != nullptr && inst.getOperand(0) == x->getOperand(1) || inst.getOperand(0) == x->getOperand(1))
-										 {
-											 constVal = constOp;
-											 replace = true;
-										 }
-									 }
-									 else
-									 {
-										 replace = false;
-									 }
-								 });
-				if (constVal != nullptr && replace)
-				{
-					inst.replaceAllUsesWith((Value *)constVal);
-					toErase.insert(&inst);
-				}
+		// pair neighbours level by level so operands available early combine first
+		stable_sort(operands, [&rank](Value *a, Value *b)
+								{ return rank.lookup(a) < rank.lookup(b); });
+		IRBuilder<> builder(root);
+		while (operands.size() > 1)
+		{
+			SmallVector<Value *, 8> level;
+			for (unsigned i = 0; i + 1 < operands.size(); i += 2)
+			{
+				level.push_back(builder.CreateBinOp(opCode, operands[i], operands[i + 1]));
 			}
+			if (operands.size() % 2 == 1)
+			{
+				level.push_back(operands.back());
+			}
+			operands = level;
+		}
+		Value *result = folded;
+		if (!operands.empty())
+		{
+			result = folded != nullptr ? builder.CreateBinOp(opCode, operands.front(), folded) : operands.front();
 		}
+		root->replaceAllUsesWith(result);
+		root->eraseFromParent();
+		for (Instruction *inst : interior)
+		{
+			inst->eraseFromParent();
+		}
+		change = true;
 	}
-	for_each(toErase, [&change](Instruction *inst)
-					 { inst->eraseFromParent(); 
-					 change = true; });
 }
 
-void optimizeModule(Module &module)
+// stores reaching the entry of each block
+struct reachingStoresAnalysis : AnalysisInfoMixin<reachingStoresAnalysis>
 {
-	for (Function &func : module.functions())
+	struct Result
+	{
+		passVector<StoreInst *> stores;
+		DenseMap<Instruction *, unsigned> storeNumber;
+		DenseMap<Value *, BitVector> storesTo; // stores to each address, by number
+		DenseMap<BasicBlock *, unsigned> blockNumber;
+		passVector<BitVector> ins;
+	};
+	static AnalysisKey Key;
+
+	Result run(Function &func, FunctionAnalysisManager &)
 	{
+		statistics["minic-analysis"]["reaching_stores"]++;
+		// number every store so reaching definitions are bit vectors
+		Result result;
+		passVector<StoreInst *> &stores = result.stores;
+		DenseMap<Instruction *, unsigned> &storeNumber = result.storeNumber;
+		for (BasicBlock &block : func)
+		{
+			for (Instruction &inst : block)
+			{
+				if (StoreInst *store = dyn_cast<StoreInst>(&inst))
+				{
+					storeNumber[store] = stores.size();
+					stores.push_back(store);
+				}
+			}
+		}
+		DenseMap<Value *, BitVector> &storesTo = result.storesTo;
+		for (StoreInst *store : stores)
+		{
+			BitVector &sameAddress = storesTo[store->getPointerOperand()];
+			sameAddress.resize(stores.size());
+			sameAddress.set(storeNumber[store]);
+		}
 
-		bool change;
+		DenseMap<BasicBlock *, unsigned> &blockNumber = result.blockNumber;
+		unsigned numBlocks = 0;
+		for (BasicBlock &block : func)
+		{
+			blockNumber[&block] = numBlocks++;
+		}
+		passVector<BitVector> kill(numBlocks, BitVector(stores.size()));
+		passVector<BitVector> gen = kill, outs = kill;
+		passVector<BitVector> &ins = result.ins;
+		ins = kill;
+
+		// generate kill gen
+		for (BasicBlock &block : func)
+		{
+			unsigned number = blockNumber[&block];
+			generateKillGen(gen[number], kill[number], storesTo, storeNumber, block);
+			outs[number] = gen[number];
+		}
+		bool tempChange = true;
+		BitVector out;
 		do
 		{
-			change = false;
+			tempChange = false;
 			for (BasicBlock &block : func)
 			{
-				eliminateCommonSubExpression(block, change);
-				eliminateDeadCode(block, change);
-				constantFolding(block, change);
+				unsigned number = blockNumber[&block];
+
+				// union of predecessor of block
+				for (BasicBlock *pred : predecessors(&block))
+				{
+					ins[number] |= outs[blockNumber[pred]];
+				}
+
+				// union(gen, diff(in, kill))
+				out = ins[number];
+				out.reset(kill[number]);
+				out |= gen[number];
+
+				// diff(out, old_out)
+				if (out != outs[number])
+				{
+					outs[number] = out;
+					tempChange = true;
+				}
+			}
+		} while (tempChange);
+		return result;
+	}
+};
+AnalysisKey reachingStoresAnalysis::Key;
+
+void constantPropagation(Function &func, FunctionAnalysisManager &analyses, bool &change)
+{
+	reachingStoresAnalysis::Result &reachingStores = analyses.getResult<reachingStoresAnalysis>(func);
+	passVector<StoreInst *> &stores = reachingStores.stores;
+	DenseMap<Instruction *, unsigned> &storeNumber = reachingStores.storeNumber;
+	DenseMap<Value *, BitVector> &storesTo = reachingStores.storesTo;
+	DominatorTree &domTree = analyses.getResult<DominatorTreeAnalysis>(func);
+	SmallVector<Instruction *, 16> toErase;
+	BitVector R, reaching;
+	for (BasicBlock &block : func)
+	{
+		R = reachingStores.ins[reachingStores.blockNumber[&block]];
+		for (Instruction &inst : block)
+		{
+			if (StoreInst *store = dyn_cast<StoreInst>(&inst))
+			{
+				R.reset(storesTo[store->getPointerOperand()]);
+				R.set(storeNumber[store]);
 			}
-			constantPropagation(func, change);
-		} while (change);
+			LoadInst *load = dyn_cast<LoadInst>(&inst);
+			auto sameAddress = load != nullptr ? storesTo.find(load->getPointerOperand()) : storesTo.end();
+			if (sameAddress == storesTo.end())
+			{
+				continue;
+			}
+			reaching = R;
+			reaching &= sameAddress->second;
+
+			// every store reaching the load must write the same value
+			Value *storedVal = nullptr;
+			bool replace{reaching.any()};
+			for (unsigned x : reaching.set_bits())
+			{
+				Value *storedOp = stores[x]->getValueOperand();
+				if (storedVal != nullptr && storedOp != storedVal)
+				{
+					replace = false;
+					break;
+				}
+				storedVal = storedOp;
+			}
+			if (!replace && isTrackedAlloca(load->getPointerOperand()))
+			{
+				missed("minic-constprop", "stores_differ", &inst, [&]
+							 { return "load of " + load->getPointerOperand()->getName().str() + " not forwarded, " +
+												to_string(reaching.count()) + " stores writing different values reach it"; });
+			}
+			if (!replace || storedVal->getType() != load->getType())
+			{
+				continue;
+			}
+			if (isa<ConstantInt>(storedVal))
+			{
+				log("minic-constprop", "propagated", [&]
+						{ return string{"CP  -> "} + getInstructionString(inst); }, &inst);
+			}
+			else
+			{
+				// other values are forwarded from allocas only, where the value must still dominate the load
+				Instruction *storedInst = dyn_cast<Instruction>(storedVal);
+				if (!isTrackedAlloca(load->getPointerOperand()) || isa<Constant>(storedVal) ||
+						(storedInst != nullptr && !domTree.dominates(storedInst, load)))
+				{
+					missed("minic-constprop", "not_dominating", &inst, [&]
+								 { return "load of " + load->getPointerOperand()->getName().str() +
+													" not forwarded, the stored value is not computed on every path to it"; });
+					continue;
+				}
+				log("minic-constprop", "forwarded", [&]
+						{ return string{"STL -> "} + getInstructionString(inst); }, &inst);
+			}
+			inst.replaceAllUsesWith(storedVal);
+			toErase.push_back(&inst);
+		}
+	}
+	for (Instruction *inst : toErase)
+	{
+		inst->eraseFromParent();
+		change = true;
+	}
+}
+
+typedef enum
+{
+	LATTICE_UNDEFINED = 0,
+	LATTICE_CONSTANT = 1,
+	LATTICE_OVERDEFINED = 2
+} latticeState;
+
+typedef struct
+{
+	latticeState state;
+	ConstantInt *value;
+} latticeValue;
+
+// meet new into old, true when old moved down the lattice
+bool mergeLattice(latticeValue &old, latticeValue update)
+{
+	if (old.state == LATTICE_OVERDEFINED || update.state == LATTICE_UNDEFINED)
+	{
+		return false;
+	}
+	if (old.state == LATTICE_UNDEFINED)
+	{
+		old = update;
+		return true;
+	}
+	if (update.state == LATTICE_CONSTANT && update.value == old.value)
+	{
+		return false;
+	}
+	old = latticeValue{LATTICE_OVERDEFINED, nullptr};
+	return true;
+}
+
+void sparseConditionalConstantPropagation(Function &func, bool &change)
+{
+	if (func.isDeclaration())
+	{
+		return;
+	}
+	DenseMap<Value *, latticeValue> lattice;
+	SmallPtrSet<BasicBlock *, 16> executable;
+	DenseSet<pair<BasicBlock *, BasicBlock *>> executableEdges;
+	passVector<BasicBlock *> blockWorklist{&func.getEntryBlock()};
+	passVector<Instruction *> instWorklist;
+
+	auto getLattice = [&lattice](Value *val) -> latticeValue
+	{
+		if (ConstantInt *constVal = dyn_cast<ConstantInt>(val))
+		{
+			return latticeValue{LATTICE_CONSTANT, constVal};
+		}
+		if (!isa<Instruction>(val) && !isTrackedAlloca(val))
+		{
+			return latticeValue{LATTICE_OVERDEFINED, nullptr};
+		}
+		auto it = lattice.find(val);
+		if (it == lattice.end())
+		{
+			return latticeValue{LATTICE_UNDEFINED, nullptr};
+		}
+		return it->second;
+	};
+
+	// lower val and queue whatever reads it
+	auto update = [&lattice, &executable, &instWorklist](Value *val, latticeValue newVal)
+	{
+		if (!mergeLattice(lattice[val], newVal))
+		{
+			return;
+		}
+		for (User *user : val->users())
+		{
+			Instruction *userInst = dyn_cast<Instruction>(user);
+			StoreInst *storeInst = dyn_cast<StoreInst>(user);
+			if (userInst != nullptr && executable.count(userInst->getParent()) &&
+					(storeInst == nullptr || storeInst->getValueOperand() == val))
+			{
+				instWorklist.push_back(userInst);
+			}
+		}
+	};
+
+	auto markEdge = [&executableEdges, &executable, &blockWorklist](BasicBlock *from, BasicBlock *to)
+	{
+		if (!executableEdges.insert(make_pair(from, to)).second)
+		{
+			return;
+		}
+		if (executable.insert(to).second)
+		{
+			blockWorklist.push_back(to);
+		}
+	};
+
+	auto visit = [&](Instruction &inst)
+	{
+		if (BranchInst *br = dyn_cast<BranchInst>(&inst))
+		{
+			if (br->isUnconditional())
+			{
+				markEdge(br->getParent(), br->getSuccessor(0));
+				return;
+			}
+			latticeValue cond = getLattice(br->getCondition());
+			if (cond.state == LATTICE_OVERDEFINED)
+			{
+				markEdge(br->getParent(), br->getSuccessor(0));
+				markEdge(br->getParent(), br->getSuccessor(1));
+			}
+			else if (cond.state == LATTICE_CONSTANT)
+			{
+				markEdge(br->getParent(), br->getSuccessor(cond.value->isZero() ? 1 : 0));
+			}
+			return;
+		}
+		if (SwitchInst *sw = dyn_cast<SwitchInst>(&inst))
+		{
+			latticeValue cond = getLattice(sw->getCondition());
+			if (cond.state == LATTICE_OVERDEFINED)
+			{
+				for (BasicBlock *succ : successors(sw->getParent()))
+				{
+					markEdge(sw->getParent(), succ);
+				}
+			}
+			else if (cond.state == LATTICE_CONSTANT)
+			{
+				markEdge(sw->getParent(), sw->findCaseValue(cond.value)->getCaseSuccessor());
+			}
+			return;
+		}
+		if (StoreInst *storeInst = dyn_cast<StoreInst>(&inst))
+		{
+			if (isTrackedAlloca(storeInst->getPointerOperand()))
+			{
+				update(storeInst->getPointerOperand(), getLattice(storeInst->getValueOperand()));
+			}
+			return;
+		}
+		if (inst.getType()->isVoidTy() || isa<AllocaInst>(inst))
+		{
+			return;
+		}
+		if (LoadInst *load = dyn_cast<LoadInst>(&inst))
+		{
+			update(&inst, isTrackedAlloca(load->getPointerOperand())
+												? getLattice(load->getPointerOperand())
+												: latticeValue{LATTICE_OVERDEFINED, nullptr});
+			return;
+		}
+		if (!isa<BinaryOperator>(inst) && !isa<ICmpInst>(inst))
+		{
+			update(&inst, latticeValue{LATTICE_OVERDEFINED, nullptr});
+			return;
+		}
+		latticeValue lhs = getLattice(inst.getOperand(0));
+		latticeValue rhs = getLattice(inst.getOperand(1));
+		if (lhs.state == LATTICE_OVERDEFINED || rhs.state == LATTICE_OVERDEFINED)
+		{
+			update(&inst, latticeValue{LATTICE_OVERDEFINED, nullptr});
+			return;
+		}
+		if (lhs.state == LATTICE_UNDEFINED || rhs.state == LATTICE_UNDEFINED)
+		{
+			return;
+		}
+		Constant *folded = nullptr;
+		if (ICmpInst *cmp = dyn_cast<ICmpInst>(&inst))
+		{
+			folded = ConstantExpr::getICmp(cmp->getPredicate(), lhs.value, rhs.value);
+		}
+		else if (!((inst.getOpcode() == Instruction::SDiv || inst.getOpcode() == Instruction::SRem) &&
+							 (rhs.value->isZero() || (rhs.value->isMinusOne() && lhs.value->isMinValue(true)))))
+		{
+			folded = ConstantExpr::get(inst.getOpcode(), lhs.value, rhs.value);
+		}
+		ConstantInt *foldedInt = dyn_cast_or_null<ConstantInt>(folded);
+		update(&inst, foldedInt != nullptr ? latticeValue{LATTICE_CONSTANT, foldedInt}
+																			 : latticeValue{LATTICE_OVERDEFINED, nullptr});
+	};
+
+	executable.insert(&func.getEntryBlock());
+	bool resolved;
+	do
+	{
+		while (!blockWorklist.empty() || !instWorklist.empty())
+		{
+			while (!instWorklist.empty())
+			{
+				Instruction *inst = instWorklist.back();
+				instWorklist.pop_back();
+				visit(*inst);
+			}
+			if (!blockWorklist.empty())
+			{
+				BasicBlock *block = blockWorklist.back();
+				blockWorklist.pop_back();
+				for (Instruction &inst : *block)
+				{
+					visit(inst);
+				}
+			}
+		}
+
+		// a branch on a value never defined has to go somewhere, take both ways
+		resolved = false;
+		for (BasicBlock *block : executable)
+		{
+			Instruction *term = block->getTerminator();
+			BranchInst *br = dyn_cast<BranchInst>(term);
+			Value *cond = br != nullptr && br->isConditional() ? br->getCondition() : nullptr;
+			if (SwitchInst *sw = dyn_cast<SwitchInst>(term))
+			{
+				cond = sw->getCondition();
+			}
+			if (cond != nullptr && getLattice(cond).state == LATTICE_UNDEFINED)
+			{
+				lattice[cond] = latticeValue{LATTICE_OVERDEFINED, nullptr};
+				instWorklist.push_back(term);
+				resolved = true;
+			}
+		}
+	} while (resolved);
+
+	// rewrite constant values and branches in executable blocks
+	for (BasicBlock *block : executable)
+	{
+		for (Instruction &inst : *block)
+		{
+			latticeValue val = getLattice(&inst);
+			if (!isa<AllocaInst>(inst) && val.state == LATTICE_CONSTANT && !inst.use_empty())
+			{
+				log("minic-sccp", "propagated", [&]
+						{ return string{"SCCP -> "} + getInstructionString(inst); }, &inst);
+				inst.replaceAllUsesWith(val.value);
+				change = true;
+			}
+		}
+		BranchInst *br = dyn_cast<BranchInst>(block->getTerminator());
+		if (br != nullptr && br->isConditional())
+		{
+			bool takeTrue = executableEdges.count(make_pair(block, br->getSuccessor(0))) > 0;
+			bool takeFalse = executableEdges.count(make_pair(block, br->getSuccessor(1))) > 0;
+			if (takeTrue != takeFalse)
+			{
+				log("minic-sccp", "branches_folded", [&]
+						{ return string{"SCCP -> "} + getInstructionString(*br); }, br);
+				BasicBlock *dead = br->getSuccessor(takeTrue ? 1 : 0);
+				BranchInst::Create(br->getSuccessor(takeTrue ? 0 : 1), br);
+				br->eraseFromParent();
+				dead->removePredecessor(block);
+				change = true;
+			}
+		}
+		SwitchInst *sw = dyn_cast<SwitchInst>(block->getTerminator());
+		latticeValue cond = sw != nullptr ? getLattice(sw->getCondition()) : latticeValue{LATTICE_OVERDEFINED, nullptr};
+		if (cond.state == LATTICE_CONSTANT)
+		{
+			log("minic-sccp", "branches_folded", [&]
+					{ return string{"SCCP -> "} + getInstructionString(*sw); }, sw);
+			BasicBlock *taken = sw->findCaseValue(cond.value)->getCaseSuccessor();
+			for (BasicBlock *dead : SmallPtrSet<BasicBlock *, 8>(succ_begin(block), succ_end(block)))
+			{
+				if (dead != taken)
+				{
+					dead->removePredecessor(block);
+				}
+			}
+			BranchInst::Create(taken, sw);
+			sw->eraseFromParent();
+			change = true;
+		}
+	}
+
+	// remove blocks no executable edge reaches
+	passVector<BasicBlock *> unreachable;
+	for (BasicBlock &block : func)
+	{
+		if (!executable.count(&block))
+		{
+			unreachable.push_back(&block);
+		}
+	}
+	for (BasicBlock *block : unreachable)
+	{
+		for (BasicBlock *succ : successors(block))
+		{
+			if (executable.count(succ))
+			{
+				succ->removePredecessor(block);
+			}
+		}
+		for (Instruction &inst : *block)
+		{
+			if (!inst.getType()->isVoidTy())
+			{
+				inst.replaceAllUsesWith(UndefValue::get(inst.getType()));
+			}
+		}
+		block->dropAllReferences();
+	}
+	for (BasicBlock *block : unreachable)
+	{
+		log("minic-sccp", "blocks_removed", [&]
+				{ return string{"SCCP -> removed unreachable block"}; });
+		block->eraseFromParent();
+		change = true;
+	}
+}
+
+// comparison known to hold between two subjects, the contents of tracked allocas or values
+typedef tuple<CmpInst::Predicate, Value *, Value *> rangeRelation;
+
+typedef struct
+{
+	passMap<Value *, ConstantRange> ranges; // contents of tracked allocas or values from earlier blocks, full when missing
+	passSet<rangeRelation> relations;
+} rangeState;
+
+ConstantRange getVariableRange(rangeState &state, Value *variable)
+{
+	auto it = state.ranges.find(variable);
+	if (it == state.ranges.end())
+	{
+		AllocaInst *alloca = dyn_cast<AllocaInst>(variable);
+		return ConstantRange::getFull((alloca != nullptr ? alloca->getAllocatedType() : variable->getType())->getIntegerBitWidth());
+	}
+	return it->second;
+}
+
+void setVariableRange(rangeState &state, Value *variable, ConstantRange range)
+{
+	if (range.isFullSet())
+	{
+		state.ranges.erase(variable);
+		return;
+	}
+	state.ranges.insert_or_assign(variable, range);
+}
+
+// join of two paths: ranges widen, relations must hold on both
+void mergeRangeState(rangeState &into, rangeState &from)
+{
+	for (auto it = into.ranges.begin(); it != into.ranges.end();)
+	{
+		auto other = from.ranges.find(it->first);
+		if (other != from.ranges.end())
+		{
+			it->second = it->second.unionWith(other->second);
+		}
+		it = other == from.ranges.end() || it->second.isFullSet() ? into.ranges.erase(it) : next(it);
+	}
+	erase_if(into.relations, [&from](const rangeRelation &known)
+					 { return !from.relations.count(known); });
+}
+
+// outcome of pred(a, b) if a known relation between the two variables decides it
+Optional<bool> isRelationImplied(rangeState &state, CmpInst::Predicate pred, Value *a, Value *b)
+{
+	for (const rangeRelation &known : state.relations)
+	{
+		CmpInst::Predicate knownPred = get<0>(known);
+		if (get<1>(known) == b && get<2>(known) == a)
+		{
+			knownPred = CmpInst::getSwappedPredicate(knownPred);
+		}
+		else if (get<1>(known) != a || get<2>(known) != b)
+		{
+			continue;
+		}
+		if (CmpInst::isImpliedTrueByMatchingCmp(knownPred, pred))
+		{
+			return true;
+		}
+		if (CmpInst::isImpliedFalseByMatchingCmp(knownPred, pred))
+		{
+			return false;
+		}
+	}
+	return None;
+}
+
+// walk block from its entry state, filling in the states on its outgoing edges
+void transferRanges(BasicBlock &block, rangeState state, SmallPtrSetImpl<Value *> &tracked,
+										passMap<pair<BasicBlock *, BasicBlock *>, rangeState> &edges, bool rewrite, bool &change)
+{
+	// what the state knows of values defined here comes from an earlier trip round a loop
+	auto definedHere = [&block](Value *val)
+	{
+		return isa<Instruction>(val) && cast<Instruction>(val)->getParent() == &block;
+	};
+	erase_if(state.ranges, [&definedHere](const pair<Value *const, ConstantRange> &entry)
+					 { return definedHere(entry.first); });
+	erase_if(state.relations, [&definedHere](const rangeRelation &known)
+					 { return definedHere(get<1>(known)) || definedHere(get<2>(known)); });
+
+	// ranges of values defined in this block, values from earlier blocks are in the state, anything else is full
+	DenseMap<Value *, ConstantRange> valueRanges;
+	// loads still holding the current contents of their alloca
+	DenseMap<Value *, Value *> loadedFrom;
+	auto rangeOf = [&valueRanges, &state, &definedHere](Value *val)
+	{
+		if (ConstantInt *constVal = dyn_cast<ConstantInt>(val))
+		{
+			return ConstantRange(constVal->getValue());
+		}
+		auto it = valueRanges.find(val);
+		if (it != valueRanges.end())
+		{
+			return it->second;
+		}
+		return definedHere(val) ? ConstantRange::getFull(val->getType()->getIntegerBitWidth()) : getVariableRange(state, val);
+	};
+	// a compared value's subject: the alloca it still holds the contents of, or the value itself once stored values are forwarded
+	auto subjectOf = [&loadedFrom](Value *val) -> Value *
+	{
+		Value *variable = loadedFrom.lookup(val);
+		return variable != nullptr ? variable : isa<ConstantInt>(val) ? nullptr : val;
+	};
+
+	for (Instruction &inst : block)
+	{
+		if (LoadInst *load = dyn_cast<LoadInst>(&inst))
+		{
+			if (tracked.count(load->getPointerOperand()))
+			{
+				valueRanges.insert(make_pair(load, getVariableRange(state, load->getPointerOperand())));
+				loadedFrom[load] = load->getPointerOperand();
+			}
+		}
+		else if (StoreInst *store = dyn_cast<StoreInst>(&inst))
+		{
+			Value *variable = store->getPointerOperand();
+			if (!tracked.count(variable))
+			{
+				continue;
+			}
+			setVariableRange(state, variable, rangeOf(store->getValueOperand()));
+			erase_if(state.relations, [variable](const rangeRelation &known)
+							 { return get<1>(known) == variable || get<2>(known) == variable; });
+			Value *copied = loadedFrom.lookup(store->getValueOperand());
+			SmallVector<Value *, 4> stale;
+			for (auto &entry : loadedFrom)
+			{
+				if (entry.second == variable)
+				{
+					stale.push_back(entry.first);
+				}
+			}
+			for (Value *load : stale)
+			{
+				loadedFrom.erase(load);
+			}
+			if (copied != nullptr && copied != variable)
+			{
+				state.relations.insert(rangeRelation{CmpInst::ICMP_EQ, variable, copied});
+			}
+		}
+		else if (isa<BinaryOperator>(inst) && inst.getType()->isIntegerTy())
+		{
+			ConstantRange result = rangeOf(inst.getOperand(0)).binaryOp(cast<BinaryOperator>(inst).getOpcode(), rangeOf(inst.getOperand(1)));
+			valueRanges.insert(make_pair(&inst, result));
+		}
+		else if (isa<CastInst>(inst) && inst.getType()->isIntegerTy() && inst.getOperand(0)->getType()->isIntegerTy())
+		{
+			ConstantRange result = rangeOf(inst.getOperand(0)).castOp(cast<CastInst>(inst).getOpcode(), inst.getType()->getIntegerBitWidth());
+			valueRanges.insert(make_pair(&inst, result));
+		}
+		else if (ICmpInst *cmp = dyn_cast<ICmpInst>(&inst))
+		{
+			if (!cmp->getOperand(0)->getType()->isIntegerTy())
+			{
+				continue;
+			}
+			ConstantRange lhs = rangeOf(cmp->getOperand(0));
+			ConstantRange rhs = rangeOf(cmp->getOperand(1));
+			Optional<bool> outcome;
+			if (lhs.icmp(cmp->getPredicate(), rhs))
+			{
+				outcome = true;
+			}
+			else if (lhs.icmp(cmp->getInversePredicate(), rhs))
+			{
+				outcome = false;
+			}
+			else
+			{
+				Value *a = subjectOf(cmp->getOperand(0));
+				Value *b = subjectOf(cmp->getOperand(1));
+				if (a != nullptr && b != nullptr && a != b)
+				{
+					outcome = isRelationImplied(state, cmp->getPredicate(), a, b);
+				}
+			}
+			if (!outcome.hasValue())
+			{
+				continue;
+			}
+			valueRanges.insert(make_pair(cmp, ConstantRange(APInt(1, *outcome))));
+			if (rewrite && !cmp->use_empty())
+			{
+				log("minic-vrp", "comparisons_removed", [&]
+						{ return string{"VRP -> "} + getInstructionString(*cmp); }, cmp);
+				cmp->replaceAllUsesWith(ConstantInt::get(cmp->getType(), *outcome));
+				change = true;
+			}
+		}
+	}
+
+	// a conditional branch on a comparison narrows its operands on each edge
+	BranchInst *br = dyn_cast<BranchInst>(block.getTerminator());
+	ICmpInst *cmp = br != nullptr && br->isConditional() ? dyn_cast<ICmpInst>(br->getCondition()) : nullptr;
+	for (unsigned i = 0; i < block.getTerminator()->getNumSuccessors(); i++)
+	{
+		BasicBlock *succ = block.getTerminator()->getSuccessor(i);
+		rangeState edge = state;
+		if (cmp != nullptr && cmp->getParent() == &block && br->getSuccessor(0) != br->getSuccessor(1))
+		{
+			CmpInst::Predicate pred = i == 0 ? cmp->getPredicate() : cmp->getInversePredicate();
+			Value *a = subjectOf(cmp->getOperand(0));
+			Value *b = subjectOf(cmp->getOperand(1));
+			if (a != nullptr)
+			{
+				ConstantRange allowed = ConstantRange::makeAllowedICmpRegion(pred, rangeOf(cmp->getOperand(1)));
+				setVariableRange(edge, a, rangeOf(cmp->getOperand(0)).intersectWith(allowed));
+			}
+			if (b != nullptr)
+			{
+				ConstantRange allowed = ConstantRange::makeAllowedICmpRegion(CmpInst::getSwappedPredicate(pred), rangeOf(cmp->getOperand(0)));
+				setVariableRange(edge, b, rangeOf(cmp->getOperand(1)).intersectWith(allowed));
+			}
+			if (a != nullptr && b != nullptr && a != b)
+			{
+				edge.relations.insert(rangeRelation{pred, a, b});
+			}
+		}
+		edges.insert_or_assign(make_pair(&block, succ), edge);
+	}
+}
+
+// forward range analysis over alloca contents and values, comparisons whose outcome is implied become constants
+void eliminateRedundantComparisons(Function &func, bool &change)
+{
+	if (func.isDeclaration())
+	{
+		return;
+	}
+	SmallPtrSet<Value *, 16> tracked;
+	for (Instruction &inst : func.getEntryBlock())
+	{
+		if (isTrackedAlloca(&inst))
+		{
+			tracked.insert(&inst);
+		}
+	}
+	ReversePostOrderTraversal<Function *> order(&func);
+	passMap<BasicBlock *, rangeState> ins;
+	passMap<pair<BasicBlock *, BasicBlock *>, rangeState> edges;
+	DenseMap<BasicBlock *, unsigned> rounds;
+	bool tempChange = true;
+	while (tempChange)
+	{
+		tempChange = false;
+		for (BasicBlock *block : order)
+		{
+			rangeState in;
+			bool reached = block == &func.getEntryBlock();
+			for (BasicBlock *pred : predecessors(block))
+			{
+				auto edge = edges.find(make_pair(pred, block));
+				if (edge == edges.end())
+				{
+					continue;
+				}
+				if (reached)
+				{
+					mergeRangeState(in, edge->second);
+				}
+				else
+				{
+					in = edge->second;
+					reached = true;
+				}
+			}
+			if (!reached)
+			{
+				continue;
+			}
+			auto old = ins.find(block);
+			if (old != ins.end())
+			{
+				// variables still moving around a loop after a few rounds go straight to full
+				if (rounds[block] >= RANGE_WIDENING_ROUNDS)
+				{
+					erase_if(in.ranges, [&old](const pair<Value *const, ConstantRange> &entry)
+									 { auto previous = old->second.ranges.find(entry.first);
+										 return previous == old->second.ranges.end() || previous->second != entry.second; });
+				}
+				if (old->second.ranges == in.ranges && old->second.relations == in.relations)
+				{
+					continue;
+				}
+				rounds[block]++;
+			}
+			ins.insert_or_assign(block, in);
+			transferRanges(*block, in, tracked, edges, false, change);
+			tempChange = true;
+		}
+	}
+
+	for (BasicBlock *block : order)
+	{
+		auto in = ins.find(block);
+		if (in != ins.end())
+		{
+			transferRanges(*block, in->second, tracked, edges, true, change);
+		}
+	}
+}
+
+// addresses stored to that may be read after the end of each block
+struct livenessAnalysis : AnalysisInfoMixin<livenessAnalysis>
+{
+	struct Result
+	{
+		DenseMap<Value *, unsigned> addressNumber;
+		DenseMap<BasicBlock *, unsigned> blockNumber;
+		passVector<BitVector> liveOut;
+	};
+	static AnalysisKey Key;
+
+	Result run(Function &func, FunctionAnalysisManager &)
+	{
+		statistics["minic-analysis"]["liveness"]++;
+		// number the addresses and blocks so liveness is bit vectors
+		Result result;
+		DenseMap<Value *, unsigned> &addressNumber = result.addressNumber;
+		DenseMap<BasicBlock *, unsigned> &blockNumber = result.blockNumber;
+		unsigned numBlocks = 0;
+		for (BasicBlock &block : func)
+		{
+			blockNumber[&block] = numBlocks++;
+			for (Instruction &inst : block)
+			{
+				if (StoreInst *storeInst = dyn_cast<StoreInst>(&inst))
+				{
+					addressNumber.try_emplace(storeInst->getPointerOperand(), addressNumber.size());
+				}
+			}
+		}
+		unsigned numAddresses = addressNumber.size();
+		passVector<BitVector> use(numBlocks, BitVector(numAddresses));
+		passVector<BitVector> def = use, liveIn = use;
+		passVector<BitVector> &liveOut = result.liveOut;
+		liveOut = use;
+		for (BasicBlock &block : func)
+		{
+			unsigned number = blockNumber[&block];
+			for (Instruction &inst : block)
+			{
+				if (LoadInst *load = dyn_cast<LoadInst>(&inst))
+				{
+					auto address = addressNumber.find(load->getPointerOperand());
+					if (address != addressNumber.end() && !def[number].test(address->second))
+					{
+						use[number].set(address->second);
+					}
+				}
+				else if (StoreInst *storeInst = dyn_cast<StoreInst>(&inst))
+				{
+					def[number].set(addressNumber[storeInst->getPointerOperand()]);
+				}
+			}
+		}
+
+		bool tempChange = true;
+		BitVector in;
+		while (tempChange)
+		{
+			tempChange = false;
+			for (BasicBlock &block : func)
+			{
+				unsigned number = blockNumber[&block];
+				for (BasicBlock *succ : successors(&block))
+				{
+					liveOut[number] |= liveIn[blockNumber[succ]];
+				}
+				in = liveOut[number];
+				in.reset(def[number]);
+				in |= use[number];
+				if (in != liveIn[number])
+				{
+					liveIn[number] = in;
+					tempChange = true;
+				}
+			}
+		}
+		return result;
+	}
+};
+AnalysisKey livenessAnalysis::Key;
+
+// backward liveness of allocas: a store nothing reads before the next store or return is dead
+void eliminateDeadStores(Function &func, FunctionAnalysisManager &analyses, bool &change)
+{
+	if (func.isDeclaration())
+	{
+		return;
+	}
+	livenessAnalysis::Result &liveness = analyses.getResult<livenessAnalysis>(func);
+	DenseMap<Value *, unsigned> &addressNumber = liveness.addressNumber;
+	SmallVector<Instruction *, 16> toErase;
+	BitVector live;
+	for (BasicBlock &block : func)
+	{
+		live = liveness.liveOut[liveness.blockNumber[&block]];
+		for (auto it = block.rbegin(); it != block.rend(); it++)
+		{
+			if (LoadInst *load = dyn_cast<LoadInst>(&*it))
+			{
+				auto address = addressNumber.find(load->getPointerOperand());
+				if (address != addressNumber.end())
+				{
+					live.set(address->second);
+				}
+			}
+			else if (StoreInst *storeInst = dyn_cast<StoreInst>(&*it))
+			{
+				Value *ptr = storeInst->getPointerOperand();
+				unsigned address = addressNumber[ptr];
+				if (isTrackedAlloca(ptr) && !live.test(address))
+				{
+					toErase.push_back(storeInst);
+				}
+				live.reset(address);
+			}
+		}
+	}
+	for (Instruction *inst : toErase)
+	{
+		log("minic-dse", "stores_removed", [&]
+				{ return string{"DSE -> "} + getInstructionString(*inst); }, inst);
+		inst->eraseFromParent();
+		change = true;
+	}
+
+	// allocas left without loads or stores
+	passVector<Instruction *> deadAllocas;
+	for (Instruction &inst : func.getEntryBlock())
+	{
+		if (isa<AllocaInst>(inst) && inst.use_empty())
+		{
+			deadAllocas.push_back(&inst);
+		}
+	}
+	for (Instruction *inst : deadAllocas)
+	{
+		log("minic-dse", "allocas_removed", [&]
+				{ return string{"DSE -> "} + getInstructionString(*inst); }, inst);
+		inst->eraseFromParent();
+		change = true;
+	}
+}
+
+// blocks the entry cannot reach, dead cycles included
+void removeUnreachableBlocks(Function &func, const char *pass, const char *prefix, bool &change)
+{
+	SmallPtrSet<BasicBlock *, 16> reachable;
+	for (BasicBlock *block : depth_first(&func.getEntryBlock()))
+	{
+		reachable.insert(block);
+	}
+	passVector<BasicBlock *> unreachable;
+	for (BasicBlock &block : func)
+	{
+		if (!reachable.count(&block))
+		{
+			unreachable.push_back(&block);
+		}
+	}
+	for (BasicBlock *block : unreachable)
+	{
+		for (BasicBlock *succ : successors(block))
+		{
+			if (reachable.count(succ))
+			{
+				succ->removePredecessor(block);
+			}
+		}
+		for (Instruction &inst : *block)
+		{
+			if (!inst.getType()->isVoidTy())
+			{
+				inst.replaceAllUsesWith(UndefValue::get(inst.getType()));
+			}
+		}
+		block->dropAllReferences();
+	}
+	for (BasicBlock *block : unreachable)
+	{
+		log(pass, "blocks_removed", [&]
+				{ return string{prefix} + " -> removed unreachable block"; });
+		block->eraseFromParent();
+		change = true;
+	}
+}
+
+void simplifyControlFlow(Function &func, bool &change)
+{
+	if (func.isDeclaration())
+	{
+		return;
+	}
+	bool tempChange = true;
+	while (tempChange)
+	{
+		tempChange = false;
+
+		// branches on constants or with both edges to the same block
+		for (BasicBlock &block : func)
+		{
+			BranchInst *br = dyn_cast<BranchInst>(block.getTerminator());
+			if (br == nullptr || br->isUnconditional())
+			{
+				continue;
+			}
+			ConstantInt *cond = dyn_cast<ConstantInt>(br->getCondition());
+			if (cond == nullptr && br->getSuccessor(0) != br->getSuccessor(1))
+			{
+				continue;
+			}
+			log("minic-simplifycfg", "branches_folded", [&]
+					{ return string{"CFG -> "} + getInstructionString(*br); }, br);
+			BasicBlock *taken = br->getSuccessor(cond != nullptr && cond->isZero() ? 1 : 0);
+			BasicBlock *other = br->getSuccessor(cond != nullptr && cond->isZero() ? 0 : 1);
+			BranchInst::Create(taken, br);
+			br->eraseFromParent();
+			if (other != taken)
+			{
+				other->removePredecessor(&block);
+			}
+			tempChange = true;
+		}
+
+		// switches on constants
+		for (BasicBlock &block : func)
+		{
+			SwitchInst *sw = dyn_cast<SwitchInst>(block.getTerminator());
+			if (sw == nullptr)
+			{
+				continue;
+			}
+			// a switch whose every case leads to one block jumps there too
+			ConstantInt *cond = dyn_cast<ConstantInt>(sw->getCondition());
+			BasicBlock *taken = cond != nullptr ? sw->findCaseValue(cond)->getCaseSuccessor() : sw->getDefaultDest();
+			if (cond == nullptr && any_of(successors(&block), [taken](BasicBlock *succ)
+																		{ return succ != taken; }))
+			{
+				continue;
+			}
+			log("minic-simplifycfg", "branches_folded", [&]
+					{ return string{"CFG -> "} + getInstructionString(*sw); }, sw);
+			for (BasicBlock *dead : SmallPtrSet<BasicBlock *, 8>(succ_begin(&block), succ_end(&block)))
+			{
+				if (dead != taken)
+				{
+					dead->removePredecessor(&block);
+				}
+			}
+			BranchInst::Create(taken, sw);
+			sw->eraseFromParent();
+			tempChange = true;
+		}
+
+		// blocks holding nothing but a jump are bypassed
+		for (BasicBlock &block : func)
+		{
+			BranchInst *br = dyn_cast<BranchInst>(block.getTerminator());
+			if (&block == &func.getEntryBlock() || br == nullptr || br->isConditional() ||
+					&block.front() != br || br->getSuccessor(0) == &block ||
+					isa<PHINode>(br->getSuccessor(0)->front()) || block.hasNPredecessors(0))
+			{
+				continue;
+			}
+			log("minic-simplifycfg", "blocks_forwarded", [&]
+					{ return string{"CFG -> forwarded empty block"}; });
+			block.replaceAllUsesWith(br->getSuccessor(0));
+			tempChange = true;
+		}
+
+		// a block and its only successor, when it is that successor's only predecessor
+		for (BasicBlock &block : func)
+		{
+			BranchInst *br = dyn_cast<BranchInst>(block.getTerminator());
+			if (br == nullptr || br->isConditional())
+			{
+				continue;
+			}
+			BasicBlock *succ = br->getSuccessor(0);
+			if (succ == &block || succ == &func.getEntryBlock() || succ->getSinglePredecessor() != &block ||
+					isa<PHINode>(succ->front()))
+			{
+				continue;
+			}
+			log("minic-simplifycfg", "blocks_merged", [&]
+					{ return string{"CFG -> merged block"}; }, br);
+			br->eraseFromParent();
+			block.getInstList().splice(block.end(), succ->getInstList());
+			succ->replaceAllUsesWith(&block);
+			succ->eraseFromParent();
+			tempChange = true;
+			break;
+		}
+
+		removeUnreachableBlocks(func, "minic-simplifycfg", "CFG", tempChange);
+		change |= tempChange;
+	}
+}
+
+typedef struct
+{
+	BasicBlock *header;
+	SmallPtrSet<BasicBlock *, 8> blocks;
+	passVector<BasicBlock *> latches;
+} naturalLoop;
+
+// natural loops from back edges (latch -> header where header dominates latch)
+passVector<naturalLoop> findNaturalLoops(Function &func, DominatorTree &domTree)
+{
+	DenseMap<BasicBlock *, naturalLoop> loopMap;
+	passVector<BasicBlock *> headers;
+	for (BasicBlock &block : func)
+	{
+		// dead blocks are dominated by everything, so they would make loops of their own
+		if (!domTree.isReachableFromEntry(&block))
+		{
+			continue;
+		}
+		for (BasicBlock *succ : successors(&block))
+		{
+			if (!domTree.dominates(succ, &block))
+			{
+				continue;
+			}
+			if (loopMap.find(succ) == loopMap.end())
+			{
+				loopMap[succ].header = succ;
+				loopMap[succ].blocks.insert(succ);
+				headers.push_back(succ);
+			}
+			naturalLoop &loop = loopMap[succ];
+			loop.latches.push_back(&block);
+
+			// everything reaching the latch without passing the header
+			passVector<BasicBlock *> worklist{&block};
+			while (!worklist.empty())
+			{
+				BasicBlock *current = worklist.back();
+				worklist.pop_back();
+				if (!loop.blocks.insert(current).second)
+				{
+					continue;
+				}
+				for (BasicBlock *pred : predecessors(current))
+				{
+					if (domTree.isReachableFromEntry(pred))
+					{
+						worklist.push_back(pred);
+					}
+				}
+			}
+		}
+	}
+	passVector<naturalLoop> loops;
+	for (BasicBlock *header : headers)
+	{
+		loops.push_back(loopMap[header]);
+	}
+	// innermost loops first
+	std::sort(loops.begin(), loops.end(), [](const naturalLoop &a, const naturalLoop &b)
+			 { return a.blocks.size() < b.blocks.size(); });
+	return loops;
+}
+
+// the single outside predecessor that only branches to the header
+BasicBlock *getPreheader(naturalLoop &loop)
+{
+	BasicBlock *preheader = nullptr;
+	for (BasicBlock *pred : predecessors(loop.header))
+	{
+		if (loop.blocks.count(pred))
+		{
+			continue;
+		}
+		if (preheader != nullptr && preheader != pred)
+		{
+			return nullptr;
+		}
+		preheader = pred;
+	}
+	if (preheader == nullptr || preheader->getTerminator()->getNumSuccessors() != 1)
+	{
+		return nullptr;
+	}
+	return preheader;
+}
+
+BasicBlock *createPreheader(naturalLoop &loop)
+{
+	passVector<BasicBlock *> outside;
+	for (BasicBlock *pred : predecessors(loop.header))
+	{
+		if (!loop.blocks.count(pred) && find(outside.begin(), outside.end(), pred) == outside.end())
+		{
+			outside.push_back(pred);
+		}
+	}
+	BasicBlock *preheader = BasicBlock::Create(loop.header->getContext(), "", loop.header->getParent(), loop.header);
+	BranchInst::Create(loop.header, preheader);
+	for (BasicBlock *pred : outside)
+	{
+		pred->getTerminator()->replaceSuccessorWith(loop.header, preheader);
+	}
+	return preheader;
+}
+
+// the loop's preheader, created when missing; enclosing loops take in the new block so the list stays usable
+BasicBlock *ensurePreheader(naturalLoop &loop, passVector<naturalLoop> &loops, const char *pass, const char *prefix, bool &change)
+{
+	BasicBlock *preheader = getPreheader(loop);
+	if (preheader != nullptr || isa<PHINode>(loop.header->front()))
+	{
+		return preheader;
+	}
+	preheader = createPreheader(loop);
+	for (naturalLoop &other : loops)
+	{
+		if (&other != &loop && other.blocks.count(loop.header))
+		{
+			other.blocks.insert(preheader);
+		}
+	}
+	log(pass, "preheaders_created", [&]
+			{ return string{prefix} + " -> created preheader"; }, loop.header->getTerminator());
+	change = true;
+	return preheader;
+}
+
+// natural loops depend on the cfg alone, so they survive passes that keep it
+struct naturalLoopAnalysis : AnalysisInfoMixin<naturalLoopAnalysis>
+{
+	struct Result
+	{
+		passVector<naturalLoop> loops;
+
+		bool invalidate(Function &func, const PreservedAnalyses &preserved, FunctionAnalysisManager::Invalidator &invalidator)
+		{
+			auto checker = preserved.getChecker<naturalLoopAnalysis>();
+			return !(checker.preserved() || checker.preservedSet<CFGAnalyses>()) ||
+						 invalidator.invalidate<DominatorTreeAnalysis>(func, preserved);
+		}
+	};
+	static AnalysisKey Key;
+
+	Result run(Function &func, FunctionAnalysisManager &analyses)
+	{
+		statistics["minic-analysis"]["loops"]++;
+		return Result{findNaturalLoops(func, analyses.getResult<DominatorTreeAnalysis>(func))};
+	}
+};
+AnalysisKey naturalLoopAnalysis::Key;
+
+// pure instructions that may execute on any path without trapping
+bool isSpeculatable(Instruction &inst)
+{
+	switch (inst.getOpcode())
+	{
+	case Instruction::Add:
+	case Instruction::Sub:
+	case Instruction::Mul:
+	case Instruction::Shl:
+	case Instruction::LShr:
+	case Instruction::AShr:
+	case Instruction::And:
+	case Instruction::Or:
+	case Instruction::Xor:
+	case Instruction::ICmp:
+	case Instruction::Select:
+	case Instruction::Trunc:
+	case Instruction::ZExt:
+	case Instruction::SExt:
+		return true;
+	case Instruction::Call:
+		return isPureCall(inst);
+	case Instruction::SDiv:
+	case Instruction::SRem:
+	{
+		ConstantInt *divisor = dyn_cast<ConstantInt>(inst.getOperand(1));
+		return divisor != nullptr && !divisor->isZero() && !divisor->isMinusOne();
+	}
+	default:
+		return false;
+	}
+}
+
+passVector<Instruction *> findLoopInvariants(naturalLoop &loop)
+{
+	SmallPtrSet<Value *, 8> storedInLoop;
+	for (BasicBlock *block : loop.blocks)
+	{
+		for (Instruction &inst : *block)
+		{
+			if (StoreInst *storeInst = dyn_cast<StoreInst>(&inst))
+			{
+				storedInLoop.insert(storeInst->getPointerOperand());
+			}
+		}
+	}
+
+	SmallPtrSet<Instruction *, 16> invariant;
+	passVector<Instruction *> order;
+	auto isInvariantOperand = [&loop, &invariant](Value *op)
+	{
+		Instruction *opInst = dyn_cast<Instruction>(op);
+		return opInst == nullptr || !loop.blocks.count(opInst->getParent()) || invariant.count(opInst);
+	};
+	bool found = true;
+	while (found)
+	{
+		found = false;
+		for (BasicBlock *block : loop.blocks)
+		{
+			for (Instruction &inst : *block)
+			{
+				if (invariant.count(&inst))
+				{
+					continue;
+				}
+				bool candidate = false;
+				if (LoadInst *load = dyn_cast<LoadInst>(&inst))
+				{
+					Value *ptr = load->getPointerOperand();
+					candidate = isTrackedAlloca(ptr) && !storedInLoop.count(ptr);
+				}
+				else if (isSpeculatable(inst))
+				{
+					candidate = all_of(inst.operands(), isInvariantOperand);
+				}
+				if (candidate)
+				{
+					invariant.insert(&inst);
+					order.push_back(&inst);
+					found = true;
+				}
+			}
+		}
+	}
+	return order;
+}
+
+void hoistLoopInvariants(Function &func, FunctionAnalysisManager &analyses, bool &change)
+{
+	if (func.isDeclaration())
+	{
+		return;
+	}
+	passVector<naturalLoop> loops = analyses.getResult<naturalLoopAnalysis>(func).loops;
+	for (naturalLoop &loop : loops)
+	{
+		for (BasicBlock &block : func)
+		{
+			for (Instruction &inst : block)
+			{
+				if (loop.blocks.count(&block) && isa<CallInst>(inst) && !isPureCall(inst))
+				{
+					missed("minic-licm", "call_in_loop", &inst, [&]
+								 { return "call to " + cast<CallInst>(inst).getCalledFunction()->getName().str() +
+													" may have side effects and stays in the loop, declare it extern pure if it has none"; });
+				}
+			}
+		}
+		passVector<Instruction *> invariants = findLoopInvariants(loop);
+		if (invariants.empty())
+		{
+			continue;
+		}
+		BasicBlock *preheader = ensurePreheader(loop, loops, "minic-licm", "LICM", change);
+		if (preheader == nullptr)
+		{
+			continue;
+		}
+		for (Instruction *inst : invariants)
+		{
+			log("minic-licm", "hoisted", [&]
+					{ return string{"LICM -> "} + getInstructionString(*inst); }, inst);
+			inst->moveBefore(preheader->getTerminator());
+			change = true;
+		}
+	}
+}
+
+// a loop branching on a condition computed outside it runs as two copies, the preheader choosing one
+void unswitchLoops(Function &func, FunctionAnalysisManager &analyses, bool &change)
+{
+	if (func.isDeclaration())
+	{
+		return;
+	}
+	bool restart = true;
+	while (restart)
+	{
+		restart = false;
+		passVector<naturalLoop> loops = analyses.getResult<naturalLoopAnalysis>(func).loops;
+		unsigned funcSize = func.getInstructionCount();
+		for (naturalLoop &loop : loops)
+		{
+			unsigned loopSize = 0;
+			for (BasicBlock *block : loop.blocks)
+			{
+				loopSize += block->size();
+			}
+			BranchInst *br = nullptr;
+			for (BasicBlock &block : func)
+			{
+				BranchInst *candidate = dyn_cast<BranchInst>(block.getTerminator());
+				if (!loop.blocks.count(&block) || candidate == nullptr || candidate->isUnconditional() || isa<Constant>(candidate->getCondition()) ||
+						candidate->getSuccessor(0) == candidate->getSuccessor(1) ||
+						!loop.blocks.count(candidate->getSuccessor(0)) || !loop.blocks.count(candidate->getSuccessor(1)))
+				{
+					continue;
+				}
+				Instruction *cond = dyn_cast<Instruction>(candidate->getCondition());
+				if (cond == nullptr || !loop.blocks.count(cond->getParent()))
+				{
+					br = candidate;
+					break;
+				}
+			}
+			// loop values used after it would need phis merging the two copies
+			bool closed = br != nullptr;
+			for (BasicBlock *block : loop.blocks)
+			{
+				for (Instruction &inst : *block)
+				{
+					closed = closed && !isa<PHINode>(inst) && all_of(inst.users(), [&loop](User *user)
+																													 { return loop.blocks.count(cast<Instruction>(user)->getParent()) > 0; });
+				}
+			}
+			if (!closed)
+			{
+				continue;
+			}
+			if (loopSize > UNSWITCH_BUDGET || funcSize + loopSize > UNSWITCH_FUNCTION_BUDGET)
+			{
+				missed("minic-unswitch", "too_large", br, [&]
+							 { return "loop of " + to_string(loopSize) + " instructions not unswitched, over the budget of " +
+												to_string(UNSWITCH_BUDGET); });
+				continue;
+			}
+			BasicBlock *preheader = ensurePreheader(loop, loops, "minic-unswitch", "UNSW", change);
+			log("minic-unswitch", "unswitched", [&]
+					{ return string{"UNSW -> "} + getInstructionString(*br); }, br);
+
+			// the copy runs when the condition is false
+			DenseMap<Value *, Value *> valueMap;
+			passVector<Instruction *> cloned;
+			passVector<BasicBlock *> loopBlocks;
+			for (BasicBlock &block : func)
+			{
+				if (loop.blocks.count(&block))
+				{
+					loopBlocks.push_back(&block);
+				}
+			}
+			for (BasicBlock *block : loopBlocks)
+			{
+				BasicBlock *copy = BasicBlock::Create(func.getContext(), "", &func);
+				valueMap[block] = copy;
+				for (Instruction &inst : *block)
+				{
+					Instruction *instCopy = inst.clone();
+					copy->getInstList().push_back(instCopy);
+					valueMap[&inst] = instCopy;
+					cloned.push_back(instCopy);
+				}
+			}
+			for (Instruction *inst : cloned)
+			{
+				for (Use &op : inst->operands())
+				{
+					auto it = valueMap.find(op.get());
+					if (it != valueMap.end())
+					{
+						op.set(it->second);
+					}
+				}
+			}
+			BranchInst *brCopy = cast<BranchInst>(valueMap[br]);
+			Value *cond = br->getCondition();
+			BranchInst::Create(br->getSuccessor(0), br);
+			br->eraseFromParent();
+			BranchInst::Create(brCopy->getSuccessor(1), brCopy);
+			brCopy->eraseFromParent();
+			Instruction *entry = preheader->getTerminator();
+			BranchInst::Create(loop.header, cast<BasicBlock>(valueMap[loop.header]), cond, entry);
+			entry->eraseFromParent();
+			// each copy keeps one side of the branch, the other side is dead there
+			removeUnreachableBlocks(func, "minic-unswitch", "UNSW", change);
+			change = true;
+			analyses.invalidate(func, PreservedAnalyses::none());
+			restart = true;
+			break;
+		}
+	}
+}
+
+// expression computed the same way in several blocks, its variables are the allocas read by current loads
+typedef struct
+{
+	Instruction *sample;		 // an occurrence to copy when inserting
+	SmallVector<Value *, 2> operands; // alloca or value per operand of sample
+	AllocaInst *temp;				 // holds the value between computation and reuse
+} redundantExpression;
+
+// rough cycles to compute an instruction again, loads of its variables included
+int64_t getRecomputeCost(Instruction &inst, SmallVectorImpl<Value *> &operands)
+{
+	int64_t cost = count_if(operands, [](Value *op)
+													{ return isa<AllocaInst>(op); });
+	switch (inst.getOpcode())
+	{
+	case Instruction::Mul:
+		return cost + 3;
+	case Instruction::SDiv:
+	case Instruction::SRem:
+		return cost + 20;
+	case Instruction::Call:
+		return cost + 10;
+	default:
+		return cost + 1;
+	}
+}
+
+// lazy code motion over allocas: computations move to the latest points that make later ones redundant
+void eliminatePartialRedundancies(Function &func, bool &change)
+{
+	if (func.isDeclaration())
+	{
+		return;
+	}
+
+	// split critical edges so computations can be placed on them
+	passVector<BasicBlock *> original;
+	for (BasicBlock &block : func)
+	{
+		original.push_back(&block);
+	}
+	passVector<BasicBlock *> edgeBlocks;
+	for (BasicBlock *block : original)
+	{
+		Instruction *term = block->getTerminator();
+		for (unsigned i = 0; term->getNumSuccessors() > 1 && i < term->getNumSuccessors(); i++)
+		{
+			BasicBlock *succ = term->getSuccessor(i);
+			if (succ->hasNPredecessorsOrMore(2))
+			{
+				BasicBlock *edge = BasicBlock::Create(func.getContext(), "", &func, succ);
+				BranchInst::Create(succ, edge);
+				term->setSuccessor(i, edge);
+				edgeBlocks.push_back(edge);
+			}
+		}
+	}
+
+	// upward-exposed computations and stored variables per block
+	passVector<BasicBlock *> blocks;
+	DenseMap<BasicBlock *, unsigned> blockNumber;
+	for (BasicBlock &block : func)
+	{
+		blockNumber[&block] = blocks.size();
+		blocks.push_back(&block);
+	}
+	passMap<expressionKey, passVector<pair<unsigned, Instruction *>>> occurrences;
+	passMap<expressionKey, SmallVector<Value *, 2>> operandsOf;
+	passVector<SmallPtrSet<Value *, 8>> stored(blocks.size());
+	for (unsigned b = 0; b < blocks.size(); b++)
+	{
+		DenseMap<Value *, Value *> current;
+		passSet<expressionKey> seen;
+		for (Instruction &inst : *blocks[b])
+		{
+			if (LoadInst *load = dyn_cast<LoadInst>(&inst))
+			{
+				if (isTrackedAlloca(load->getPointerOperand()))
+				{
+					current[load] = load->getPointerOperand();
+				}
+				continue;
+			}
+			if (StoreInst *store = dyn_cast<StoreInst>(&inst))
+			{
+				Value *variable = store->getPointerOperand();
+				stored[b].insert(variable);
+				SmallVector<Value *, 4> stale;
+				for (auto &entry : current)
+				{
+					if (entry.second == variable)
+					{
+						stale.push_back(entry.first);
+					}
+				}
+				for (Value *load : stale)
+				{
+					current.erase(load);
+				}
+				continue;
+			}
+			if (!isSpeculatable(inst) || inst.getNumOperands() > 2 || !inst.getType()->isIntegerTy())
+			{
+				continue;
+			}
+			SmallVector<Value *, 2> operands;
+			bool exposed = true;
+			for (Value *op : inst.operands())
+			{
+				Value *variable = current.lookup(op);
+				operands.push_back(variable != nullptr ? variable : op);
+				exposed = exposed && (variable == nullptr || !stored[b].count(variable));
+			}
+			// reuse goes through a temp, a store and a load, so cheaper expressions are recomputed;
+			// a compare feeding only branches stays next to them, where jump threading and the backends read it
+			bool branchesOnly = isa<CmpInst>(inst) && all_of(inst.users(), [](User *user)
+																										 { return isa<BranchInst>(user); });
+			if (branchesOnly || getRecomputeCost(inst, operands) <= PRE_TEMP_COST)
+			{
+				continue;
+			}
+			unsigned opCode = inst.getOpcode() << 8;
+			if (CmpInst *cmp = dyn_cast<CmpInst>(&inst))
+			{
+				opCode |= cmp->getPredicate();
+			}
+			Value *op1 = operands[0];
+			Value *op2 = operands.size() > 1 ? operands[1] : nullptr;
+			if (inst.isCommutative() && op1 < op2)
+			{
+				swap(op1, op2);
+			}
+			expressionKey key{opCode, inst.getType(), op1, op2};
+			if (exposed && seen.insert(key).second)
+			{
+				occurrences[key].push_back(make_pair(b, &inst));
+				operandsOf.try_emplace(key, operands);
+			}
+		}
+	}
+
+	// only expressions computed in more than one block can be redundant
+	passVector<redundantExpression> expressions;
+	passVector<BitVector> use(blocks.size()), kill(blocks.size());
+	passVector<passVector<Instruction *>> occurrence(blocks.size());
+	for (auto &entry : occurrences)
+	{
+		if (entry.second.size() < 2)
+		{
+			continue;
+		}
+		unsigned x = expressions.size();
+		SmallVector<Value *, 2> &operands = operandsOf[entry.first];
+		expressions.push_back(redundantExpression{entry.second.front().second, operands, nullptr});
+		for (unsigned b = 0; b < blocks.size(); b++)
+		{
+			use[b].push_back(false);
+			kill[b].push_back(any_of(operands, [&stored, b](Value *op)
+															 { return stored[b].count(op) > 0; }));
+			occurrence[b].push_back(nullptr);
+		}
+		for (auto &found : entry.second)
+		{
+			use[found.first].set(x);
+			occurrence[found.first][x] = found.second;
+		}
+	}
+
+	unsigned n = expressions.size();
+	passVector<BitVector> anticipatedIn(blocks.size(), BitVector(n, true));
+	passVector<BitVector> availableOut(blocks.size(), BitVector(n, true));
+	passVector<BitVector> availableIn(blocks.size()), earliest(blocks.size());
+	passVector<BitVector> postponableIn(blocks.size()), postponableOut(blocks.size(), BitVector(n, true));
+	passVector<BitVector> latest(blocks.size()), usedOut(blocks.size(), BitVector(n));
+	auto meetOverPreds = [&blockNumber, &func, n](BasicBlock *block, passVector<BitVector> &outs)
+	{
+		BitVector in(n, block != &func.getEntryBlock() && !pred_empty(block));
+		if (block != &func.getEntryBlock())
+		{
+			for (BasicBlock *pred : predecessors(block))
+			{
+				in &= outs[blockNumber[pred]];
+			}
+		}
+		return in;
+	};
+
+	// anticipated: computed on every path from the block before its variables change
+	bool tempChange = n > 0;
+	while (tempChange)
+	{
+		tempChange = false;
+		for (unsigned b = blocks.size(); b-- > 0;)
+		{
+			BitVector out(n, succ_size(blocks[b]) > 0);
+			for (BasicBlock *succ : successors(blocks[b]))
+			{
+				out &= anticipatedIn[blockNumber[succ]];
+			}
+			out.reset(kill[b]);
+			out |= use[b];
+			if (out != anticipatedIn[b])
+			{
+				anticipatedIn[b] = out;
+				tempChange = true;
+			}
+		}
+	}
+
+	// available if anticipated computations were placed as early as possible
+	tempChange = n > 0;
+	while (tempChange)
+	{
+		tempChange = false;
+		for (unsigned b = 0; b < blocks.size(); b++)
+		{
+			availableIn[b] = meetOverPreds(blocks[b], availableOut);
+			BitVector out = availableIn[b];
+			out |= anticipatedIn[b];
+			out.reset(kill[b]);
+			if (out != availableOut[b])
+			{
+				availableOut[b] = out;
+				tempChange = true;
+			}
+		}
+	}
+	for (unsigned b = 0; b < blocks.size(); b++)
+	{
+		earliest[b] = anticipatedIn[b];
+		earliest[b].reset(availableIn[b]);
+	}
+
+	// postponable: placement can move down until a block uses the value
+	tempChange = n > 0;
+	while (tempChange)
+	{
+		tempChange = false;
+		for (unsigned b = 0; b < blocks.size(); b++)
+		{
+			postponableIn[b] = meetOverPreds(blocks[b], postponableOut);
+			BitVector out = postponableIn[b];
+			out |= earliest[b];
+			out.reset(use[b]);
+			if (out != postponableOut[b])
+			{
+				postponableOut[b] = out;
+				tempChange = true;
+			}
+		}
+	}
+	for (unsigned b = 0; b < blocks.size(); b++)
+	{
+		BitVector successorsReady(n, true);
+		for (BasicBlock *succ : successors(blocks[b]))
+		{
+			BitVector ready = earliest[blockNumber[succ]];
+			ready |= postponableIn[blockNumber[succ]];
+			successorsReady &= ready;
+		}
+		successorsReady.flip();
+		successorsReady |= use[b];
+		latest[b] = earliest[b];
+		latest[b] |= postponableIn[b];
+		latest[b] &= successorsReady;
+	}
+
+	// used: the value placed at latest is read further down
+	tempChange = n > 0;
+	while (tempChange)
+	{
+		tempChange = false;
+		for (unsigned b = blocks.size(); b-- > 0;)
+		{
+			BitVector out(n);
+			for (BasicBlock *succ : successors(blocks[b]))
+			{
+				unsigned s = blockNumber[succ];
+				BitVector in = usedOut[s];
+				in |= use[s];
+				in.reset(latest[s]);
+				out |= in;
+			}
+			if (out != usedOut[b])
+			{
+				usedOut[b] = out;
+				tempChange = true;
+			}
+		}
+	}
+
+	DominatorTree domTree(func);
+	for (unsigned x = 0; x < n; x++)
+	{
+		redundantExpression &expr = expressions[x];
+		passVector<unsigned> inserts, replaces;
+		bool placeable = true;
+		for (unsigned b = 0; b < blocks.size(); b++)
+		{
+			if (latest[b].test(x) && usedOut[b].test(x) && !use[b].test(x))
+			{
+				inserts.push_back(b);
+				// values that are not variables must already be computed at the block
+				placeable = placeable && all_of(expr.operands, [&domTree, &blocks, b](Value *op)
+																				{ Instruction *opInst = dyn_cast<Instruction>(op);
+																					return opInst == nullptr || isa<AllocaInst>(opInst) ||
+																								 domTree.properlyDominates(opInst->getParent(), blocks[b]); });
+			}
+			if (use[b].test(x) && !latest[b].test(x))
+			{
+				replaces.push_back(b);
+			}
+		}
+		if (!placeable && !replaces.empty())
+		{
+			missed("minic-pre", "not_placeable", expr.sample, [&]
+						 { return getInstructionString(*expr.sample) + " not moved, an operand is not computed where it would go"; });
+		}
+		if (!placeable || replaces.empty())
+		{
+			continue;
+		}
+		Type *type = expr.sample->getType();
+		BasicBlock &entryBlock = func.getEntryBlock();
+		expr.temp = new AllocaInst(type, 0, "pre", &*entryBlock.getFirstInsertionPt());
+		for (unsigned b = 0; b < blocks.size(); b++)
+		{
+			Instruction *inst = occurrence[b][x];
+			if (inst != nullptr && latest[b].test(x) && usedOut[b].test(x))
+			{
+				new StoreInst(inst, expr.temp, inst->getNextNode());
+			}
+		}
+		for (unsigned b : inserts)
+		{
+			log("minic-pre", "inserted", [&]
+					{ return string{"PRE -> inserted "} + getInstructionString(*expr.sample); }, expr.sample);
+			Instruction *before = &*blocks[b]->getFirstInsertionPt();
+			Instruction *copy = expr.sample->clone();
+			for (unsigned i = 0; i < expr.operands.size(); i++)
+			{
+				Value *op = expr.operands[i];
+				AllocaInst *variable = dyn_cast<AllocaInst>(op);
+				if (variable != nullptr && isa<LoadInst>(expr.sample->getOperand(i)))
+				{
+					op = new LoadInst(variable->getAllocatedType(), variable, "", before);
+				}
+				copy->setOperand(i, op);
+			}
+			copy->insertBefore(before);
+			new StoreInst(copy, expr.temp, before);
+		}
+		for (unsigned b : replaces)
+		{
+			Instruction *inst = occurrence[b][x];
+			log("minic-pre", "replaced", [&]
+					{ return string{"PRE -> "} + getInstructionString(*inst); }, inst);
+			inst->replaceAllUsesWith(new LoadInst(type, expr.temp, "", inst));
+			inst->eraseFromParent();
+		}
+		change = true;
+	}
+
+	// edges nothing was placed on go back to direct branches
+	for (BasicBlock *edge : edgeBlocks)
+	{
+		if (edge->size() == 1)
+		{
+			edge->getSinglePredecessor()->getTerminator()->replaceSuccessorWith(edge, edge->getTerminator()->getSuccessor(0));
+			edge->eraseFromParent();
+		}
+	}
+}
+
+typedef struct
+{
+	Value *variable;
+	StoreInst *update;
+	ConstantInt *step;
+} inductionVariable;
+
+// allocas advanced by a constant exactly once on every iteration
+passVector<inductionVariable> findBasicInductionVariables(naturalLoop &loop, DominatorTree &domTree)
+{
+	MapVector<Value *, SmallVector<StoreInst *, 2>> stores;
+	for (BasicBlock *block : loop.blocks)
+	{
+		for (Instruction &inst : *block)
+		{
+			if (StoreInst *storeInst = dyn_cast<StoreInst>(&inst))
+			{
+				stores[storeInst->getPointerOperand()].push_back(storeInst);
+			}
+		}
+	}
+	passVector<inductionVariable> ivs;
+	for (auto &entry : stores)
+	{
+		if (entry.second.size() != 1 || !isTrackedAlloca(entry.first))
+		{
+			continue;
+		}
+		StoreInst *update = entry.second.front();
+		BinaryOperator *next = dyn_cast<BinaryOperator>(update->getValueOperand());
+		if (next == nullptr || (next->getOpcode() != Instruction::Add && next->getOpcode() != Instruction::Sub))
+		{
+			continue;
+		}
+		LoadInst *current = dyn_cast<LoadInst>(next->getOperand(0));
+		ConstantInt *step = dyn_cast<ConstantInt>(next->getOperand(1));
+		if (next->getOpcode() == Instruction::Add && (current == nullptr || step == nullptr))
+		{
+			current = dyn_cast<LoadInst>(next->getOperand(1));
+			step = dyn_cast<ConstantInt>(next->getOperand(0));
+		}
+		if (current == nullptr || step == nullptr || step->isZero() ||
+				current->getPointerOperand() != entry.first)
+		{
+			continue;
+		}
+		if (next->getOpcode() == Instruction::Sub)
+		{
+			step = cast<ConstantInt>(ConstantExpr::getNeg(step));
+		}
+		bool everyIteration = all_of(loop.latches, [&domTree, update](BasicBlock *latch)
+																 { return domTree.dominates(update->getParent(), latch); });
+		if (everyIteration)
+		{
+			ivs.push_back(inductionVariable{entry.first, update, step});
+		}
+	}
+	return ivs;
+}
+
+// constant stored to ptr on the straight-line path into block, if any
+ConstantInt *findEntryValue(BasicBlock *block, Value *ptr)
+{
+	SmallPtrSet<BasicBlock *, 8> visited;
+	while (block != nullptr && visited.insert(block).second)
+	{
+		for (auto it = block->rbegin(); it != block->rend(); it++)
+		{
+			StoreInst *storeInst = dyn_cast<StoreInst>(&*it);
+			if (storeInst != nullptr && storeInst->getPointerOperand() == ptr)
+			{
+				return dyn_cast<ConstantInt>(storeInst->getValueOperand());
+			}
+		}
+		block = block->getSinglePredecessor();
+	}
+	return nullptr;
+}
+
+bool fitsInType(int64_t value, Type *type)
+{
+	unsigned width = type->getIntegerBitWidth();
+	return value >= -(int64_t{1} << (width - 1)) && value < (int64_t{1} << (width - 1));
+}
+
+// rewrite the exit test on iv into one on the reduced variable, when no value can overflow
+bool replaceLoopTest(naturalLoop &loop, BasicBlock *preheader, inductionVariable &iv,
+										 Value *reduced, ConstantInt *factor)
+{
+	BranchInst *br = dyn_cast<BranchInst>(loop.header->getTerminator());
+	if (br == nullptr || br->isUnconditional())
+	{
+		return false;
+	}
+	ICmpInst *cmp = dyn_cast<ICmpInst>(br->getCondition());
+	if (cmp == nullptr || !cmp->isRelational() || !cmp->isSigned())
+	{
+		return false;
+	}
+	LoadInst *load = dyn_cast<LoadInst>(cmp->getOperand(0));
+	ConstantInt *bound = dyn_cast<ConstantInt>(cmp->getOperand(1));
+	ConstantInt *init = findEntryValue(preheader, iv.variable);
+	if (load == nullptr || bound == nullptr || init == nullptr || factor->getSExtValue() <= 0 ||
+			load->getPointerOperand() != iv.variable || !loop.blocks.count(load->getParent()))
+	{
+		return false;
+	}
+
+	// the variable must move towards the bound while the loop keeps running
+	CmpInst::Predicate stay = loop.blocks.count(br->getSuccessor(0)) ? cmp->getPredicate() : cmp->getInversePredicate();
+	int64_t step = iv.step->getSExtValue();
+	bool rising = stay == CmpInst::ICMP_SLT || stay == CmpInst::ICMP_SLE;
+	if ((rising && step < 0) || (!rising && step > 0))
+	{
+		return false;
+	}
+	int64_t k = factor->getSExtValue();
+	int64_t lo = min(init->getSExtValue(), bound->getSExtValue()) - abs(step);
+	int64_t hi = max(init->getSExtValue(), bound->getSExtValue()) + abs(step);
+	Type *type = load->getType();
+	if (!fitsInType(lo, type) || !fitsInType(hi, type) || !fitsInType(lo * k, type) || !fitsInType(hi * k, type))
+	{
+		return false;
+	}
+	log("minic-iv", "tests_replaced", [&]
+			{ return string{"LFTR -> "} + getInstructionString(*cmp); }, cmp);
+	cmp->setOperand(0, new LoadInst(type, reduced, "", cmp));
+	cmp->setOperand(1, ConstantInt::get(type, bound->getSExtValue() * k, true));
+	return true;
+}
+
+// drop an induction variable whose only reader is its own increment
+void removeInductionVariable(inductionVariable &iv)
+{
+	Instruction *next = cast<Instruction>(iv.update->getValueOperand());
+	passVector<Instruction *> toErase;
+	for (User *user : iv.variable->users())
+	{
+		if (isa<LoadInst>(user))
+		{
+			if (!all_of(user->users(), [next](User *u)
+									{ return u == next; }))
+			{
+				return;
+			}
+		}
+		toErase.push_back(cast<Instruction>(user));
+	}
+	if (!next->hasOneUse())
+	{
+		return;
+	}
+	log("minic-iv", "variables_removed", [&]
+			{ return string{"IV  -> removed "} + iv.variable->getName().str(); });
+	iv.update->eraseFromParent();
+	next->eraseFromParent();
+	for (Instruction *inst : toErase)
+	{
+		if (inst != iv.update)
+		{
+			inst->eraseFromParent();
+		}
+	}
+	cast<Instruction>(iv.variable)->eraseFromParent();
+}
+
+void reduceInductionVariables(Function &func, FunctionAnalysisManager &analyses, bool &change)
+{
+	if (func.isDeclaration())
+	{
+		return;
+	}
+	DominatorTree &domTree = analyses.getResult<DominatorTreeAnalysis>(func);
+	passVector<naturalLoop> loops = analyses.getResult<naturalLoopAnalysis>(func).loops;
+	for (naturalLoop &loop : loops)
+	{
+		BasicBlock *preheader = getPreheader(loop);
+		if (preheader == nullptr)
+		{
+			continue;
+		}
+		for (inductionVariable &iv : findBasicInductionVariables(loop, domTree))
+		{
+			// multiplies of the variable by a loop-invariant factor, grouped by factor
+			MapVector<Value *, SmallVector<pair<LoadInst *, Instruction *>, 4>> derived;
+			for (User *user : iv.variable->users())
+			{
+				LoadInst *load = dyn_cast<LoadInst>(user);
+				if (load == nullptr || !loop.blocks.count(load->getParent()))
+				{
+					continue;
+				}
+				for (User *loadUser : load->users())
+				{
+					BinaryOperator *mul = dyn_cast<BinaryOperator>(loadUser);
+					if (mul == nullptr)
+					{
+						continue;
+					}
+					Value *factor = mul->getOperand(0) == load ? mul->getOperand(1) : mul->getOperand(0);
+					if (mul->getOpcode() == Instruction::Shl)
+					{
+						// x << k is x * 2^k
+						ConstantInt *amount = dyn_cast<ConstantInt>(mul->getOperand(1));
+						if (mul->getOperand(0) != load || amount == nullptr)
+						{
+							continue;
+						}
+						factor = ConstantExpr::getShl(ConstantInt::get(amount->getType(), 1), amount);
+					}
+					else if (mul->getOpcode() != Instruction::Mul)
+					{
+						continue;
+					}
+					Instruction *factorInst = dyn_cast<Instruction>(factor);
+					if (factor != load && (factorInst == nullptr || !loop.blocks.count(factorInst->getParent())))
+					{
+						derived[factor].push_back(make_pair(load, mul));
+					}
+				}
+			}
+
+			bool reducedTest = false;
+			for (auto &entry : derived)
+			{
+				Value *factor = entry.first;
+				Type *type = iv.update->getValueOperand()->getType();
+				BasicBlock &entryBlock = func.getEntryBlock();
+				AllocaInst *reduced = new AllocaInst(type, 0, iv.variable->getName() + ".sr", &*entryBlock.getFirstInsertionPt());
+
+				// reduced = iv * factor on entry, then advanced with iv by step * factor
+				Instruction *preTerm = preheader->getTerminator();
+				ConstantInt *init = findEntryValue(preheader, iv.variable);
+				ConstantInt *constFactor = dyn_cast<ConstantInt>(factor);
+				Value *start = nullptr;
+				Value *stride = nullptr;
+				if (init != nullptr && constFactor != nullptr)
+				{
+					start = ConstantExpr::getMul(init, constFactor);
+				}
+				else
+				{
+					start = BinaryOperator::CreateMul(new LoadInst(type, iv.variable, "", preTerm), factor, "", preTerm);
+				}
+				if (constFactor != nullptr)
+				{
+					stride = ConstantExpr::getMul(iv.step, constFactor);
+				}
+				else
+				{
+					stride = BinaryOperator::CreateMul(iv.step, factor, "", preTerm);
+				}
+				new StoreInst(start, reduced, preTerm);
+				Instruction *after = iv.update->getNextNode();
+				Value *advanced = BinaryOperator::CreateAdd(new LoadInst(type, reduced, "", after), stride, "", after);
+				new StoreInst(advanced, reduced, after);
+
+				DenseMap<LoadInst *, LoadInst *> replacement;
+				for (auto &use : entry.second)
+				{
+					if (replacement.find(use.first) == replacement.end())
+					{
+						replacement[use.first] = new LoadInst(type, reduced, "", use.first->getNextNode());
+					}
+					log("minic-iv", "reduced", [&]
+							{ return string{"SR  -> "} + getInstructionString(*use.second); }, use.second);
+					use.second->replaceAllUsesWith(replacement[use.first]);
+				}
+				change = true;
+
+				if (!reducedTest && constFactor != nullptr)
+				{
+					reducedTest = replaceLoopTest(loop, preheader, iv, reduced, constFactor);
+				}
+			}
+			if (reducedTest)
+			{
+				removeInductionVariable(iv);
+			}
+		}
+	}
+}
+
+// profile scale for the unroll budgets: 0 for a loop that never ran, 2 for a hot one, 1 without a profile
+int64_t unrollBudgetScale(naturalLoop &loop)
+{
+	uint64_t stay, leave;
+	if (!loop.header->getTerminator()->extractProfMetadata(stay, leave))
+	{
+		return 1;
+	}
+	if (stay + leave == 0)
+	{
+		return 0;
+	}
+	return stay + leave >= PROFILE_HOT_COUNT ? 2 : 1;
+}
+
+bool isUnrollDisabled(naturalLoop &loop)
+{
+	for (BasicBlock *latch : loop.latches)
+	{
+		if (latch->getTerminator()->getMetadata(LLVMContext::MD_loop) != nullptr)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void disableUnroll(Instruction *latchBr)
+{
+	LLVMContext &context = latchBr->getContext();
+	MDNode *disable = MDNode::get(context, MDString::get(context, "llvm.loop.unroll.disable"));
+	MDNode *loopID = MDNode::getDistinct(context, {nullptr, disable});
+	loopID->replaceOperandWith(0, loopID);
+	latchBr->setMetadata(LLVMContext::MD_loop, loopID);
+}
+
+// iterations of a single-exit loop testing a basic induction variable against a constant, -1 if unknown
+int64_t computeTripCount(naturalLoop &loop, BasicBlock *preheader, DominatorTree &domTree)
+{
+	BranchInst *br = dyn_cast<BranchInst>(loop.header->getTerminator());
+	if (br == nullptr || br->isUnconditional() || isa<PHINode>(loop.header->front()) ||
+			loop.blocks.count(br->getSuccessor(0)) == loop.blocks.count(br->getSuccessor(1)))
+	{
+		return -1;
+	}
+	for (BasicBlock *block : loop.blocks)
+	{
+		for (BasicBlock *succ : successors(block))
+		{
+			if (block != loop.header && !loop.blocks.count(succ))
+			{
+				return -1;
+			}
+		}
+	}
+	ICmpInst *cmp = dyn_cast<ICmpInst>(br->getCondition());
+	if (cmp == nullptr || cmp->getParent() != loop.header)
+	{
+		return -1;
+	}
+	LoadInst *load = dyn_cast<LoadInst>(cmp->getOperand(0));
+	ConstantInt *bound = dyn_cast<ConstantInt>(cmp->getOperand(1));
+	if (load == nullptr || bound == nullptr || load->getParent() != loop.header)
+	{
+		return -1;
+	}
+	for (inductionVariable &iv : findBasicInductionVariables(loop, domTree))
+	{
+		if (iv.variable != load->getPointerOperand() || iv.update->getParent() == loop.header)
+		{
+			continue;
+		}
+		ConstantInt *init = findEntryValue(preheader, iv.variable);
+		if (init == nullptr)
+		{
+			return -1;
+		}
+
+		// run the exit test with the variable's wrapping arithmetic
+		bool stayOnTrue = loop.blocks.count(br->getSuccessor(0)) > 0;
+		APInt value = init->getValue();
+		int64_t count = 0;
+		while (ICmpInst::compare(value, bound->getValue(), cmp->getPredicate()) == stayOnTrue)
+		{
+			value += iv.step->getValue();
+			if (++count > MAX_TRIP_COUNT)
+			{
+				return -1;
+			}
+		}
+		return count;
+	}
+	return -1;
+}
+
+// count copies of the loop, each header copy jumping straight into its body, the last ending at target
+BasicBlock *cloneLoopIterations(naturalLoop &loop, BasicBlock *bodyEntry, int64_t count,
+																BasicBlock *target, passVector<Instruction *> *lastLatches)
+{
+	Function *func = loop.header->getParent();
+	LLVMContext &context = func->getContext();
+	if (count == 0)
+	{
+		return target;
+	}
+	BasicBlock *first = BasicBlock::Create(context, "", func, target);
+	BasicBlock *next = first;
+	for (int64_t k = 0; k < count; k++)
+	{
+		DenseMap<Value *, Value *> valueMap;
+		passVector<Instruction *> cloned;
+		BasicBlock *headerCopy = next;
+		auto copyInto = [&valueMap, &cloned](Instruction &inst, BasicBlock *dest)
+		{
+			Instruction *copy = inst.clone();
+			dest->getInstList().push_back(copy);
+			valueMap[&inst] = copy;
+			cloned.push_back(copy);
+		};
+		for (Instruction &inst : *loop.header)
+		{
+			if (!inst.isTerminator())
+			{
+				copyInto(inst, headerCopy);
+			}
+		}
+		for (BasicBlock &block : *func)
+		{
+			if (&block != loop.header && loop.blocks.count(&block))
+			{
+				valueMap[&block] = BasicBlock::Create(context, "", func, target);
+			}
+		}
+		for (BasicBlock &block : *func)
+		{
+			if (&block != loop.header && loop.blocks.count(&block))
+			{
+				for (Instruction &inst : block)
+				{
+					copyInto(inst, cast<BasicBlock>(valueMap[&block]));
+				}
+			}
+		}
+		next = k + 1 < count ? BasicBlock::Create(context, "", func, target) : target;
+		valueMap[loop.header] = next;
+		BranchInst::Create(cast<BasicBlock>(valueMap[bodyEntry]), headerCopy);
+		for (Instruction *inst : cloned)
+		{
+			for (Use &op : inst->operands())
+			{
+				auto it = valueMap.find(op.get());
+				if (it != valueMap.end())
+				{
+					op.set(it->second);
+				}
+			}
+		}
+		if (next == target && lastLatches != nullptr)
+		{
+			for (BasicBlock *latch : loop.latches)
+			{
+				lastLatches->push_back(cast<BasicBlock>(valueMap[latch])->getTerminator());
+			}
+		}
+	}
+	return first;
+}
+
+void deleteLoop(naturalLoop &loop)
+{
+	for (BasicBlock *block : loop.blocks)
+	{
+		block->dropAllReferences();
+	}
+	for (BasicBlock *block : loop.blocks)
+	{
+		block->eraseFromParent();
+	}
+}
+
+void unrollLoops(Function &func, FunctionAnalysisManager &analyses, bool &change)
+{
+	if (func.isDeclaration())
+	{
+		return;
+	}
+	bool restart = true;
+	while (restart)
+	{
+		restart = false;
+		DominatorTree &domTree = analyses.getResult<DominatorTreeAnalysis>(func);
+		passVector<naturalLoop> loops = analyses.getResult<naturalLoopAnalysis>(func).loops;
+		for (naturalLoop &loop : loops)
+		{
+			BasicBlock *preheader = getPreheader(loop);
+			if (preheader == nullptr || isUnrollDisabled(loop))
+			{
+				continue;
+			}
+			int64_t tripCount = computeTripCount(loop, preheader, domTree);
+			if (tripCount < 0)
+			{
+				missed("minic-unroll", "unknown_trip_count", loop.header->getTerminator(), [&]
+							 { return string{"loop not unrolled, its trip count is not a known constant"}; });
+				continue;
+			}
+			int64_t loopSize = 0;
+			for (BasicBlock *block : loop.blocks)
+			{
+				loopSize += block->size();
+			}
+			BranchInst *br = cast<BranchInst>(loop.header->getTerminator());
+			bool stayOnTrue = loop.blocks.count(br->getSuccessor(0)) > 0;
+			BasicBlock *bodyEntry = br->getSuccessor(stayOnTrue ? 0 : 1);
+			BasicBlock *exitBlock = br->getSuccessor(stayOnTrue ? 1 : 0);
+
+			int64_t scale = unrollBudgetScale(loop);
+			if (tripCount * loopSize <= FULL_UNROLL_BUDGET * scale)
+			{
+				// the last header copy is the one leaving the loop
+				log("minic-unroll", "fully_unrolled", [&]
+						{ return string{"UNROLL -> fully unrolled "} + to_string(tripCount) + " iterations"; }, br);
+				BasicBlock *finalHeader = BasicBlock::Create(func.getContext(), "", &func, exitBlock);
+				DenseMap<Value *, Value *> valueMap;
+				for (Instruction &inst : *loop.header)
+				{
+					if (!inst.isTerminator())
+					{
+						Instruction *copy = inst.clone();
+						finalHeader->getInstList().push_back(copy);
+						valueMap[&inst] = copy;
+					}
+				}
+				for (Instruction &copy : *finalHeader)
+				{
+					for (Use &op : copy.operands())
+					{
+						auto it = valueMap.find(op.get());
+						if (it != valueMap.end())
+						{
+							op.set(it->second);
+						}
+					}
+				}
+				for (auto &entry : valueMap)
+				{
+					entry.first->replaceUsesWithIf(entry.second, [&loop](Use &use)
+																				 { return !loop.blocks.count(cast<Instruction>(use.getUser())->getParent()); });
+				}
+				BranchInst::Create(exitBlock, finalHeader);
+				BasicBlock *first = cloneLoopIterations(loop, bodyEntry, tripCount, finalHeader, nullptr);
+				preheader->getTerminator()->replaceSuccessorWith(loop.header, first);
+				deleteLoop(loop);
+				change = true;
+				analyses.invalidate(func, PreservedAnalyses::none());
+				restart = true;
+				break;
+			}
+
+			int64_t factor = UNROLL_FACTOR;
+			if (factor < 2 || tripCount < factor || loopSize * factor > PARTIAL_UNROLL_BUDGET * scale)
+			{
+				missed("minic-unroll", "too_large", br, [&]
+							 { return "loop of " + to_string(loopSize) + " instructions running " + to_string(tripCount) +
+												" times not unrolled, over the budget"; });
+				continue;
+			}
+			// peel the remainder so the loop runs a multiple of factor times, then test once per factor iterations
+			log("minic-unroll", "partially_unrolled", [&]
+					{ return string{"UNROLL -> unrolled by "} + to_string(factor) + " with " + to_string(tripCount % factor) + " peeled"; }, br);
+			BasicBlock *peeled = cloneLoopIterations(loop, bodyEntry, tripCount % factor, loop.header, nullptr);
+			passVector<Instruction *> lastLatches;
+			BasicBlock *second = cloneLoopIterations(loop, bodyEntry, factor - 1, loop.header, &lastLatches);
+			for (BasicBlock *latch : loop.latches)
+			{
+				latch->getTerminator()->replaceSuccessorWith(loop.header, second);
+			}
+			preheader->getTerminator()->replaceSuccessorWith(loop.header, peeled);
+			for (Instruction *latchBr : lastLatches)
+			{
+				disableUnroll(latchBr);
+			}
+			change = true;
+			analyses.invalidate(func, PreservedAnalyses::none());
+			restart = true;
+			break;
+		}
+	}
+}
+
+// whether unrollLoops fully or partially unrolls a loop with this trip count
+bool isUnrollable(naturalLoop &loop, int64_t tripCount)
+{
+	if (tripCount < 0 || isUnrollDisabled(loop))
+	{
+		return false;
+	}
+	int64_t loopSize = 0;
+	for (BasicBlock *block : loop.blocks)
+	{
+		loopSize += block->size();
+	}
+	int64_t factor = UNROLL_FACTOR;
+	int64_t scale = unrollBudgetScale(loop);
+	return tripCount * loopSize <= FULL_UNROLL_BUDGET * scale ||
+				 (factor >= 2 && tripCount >= factor && loopSize * factor <= PARTIAL_UNROLL_BUDGET * scale);
+}
+
+// header instructions copied to the end of block in place of its branch to the header
+void copyHeader(BasicBlock *header, BasicBlock *block)
+{
+	Instruction *oldBr = block->getTerminator();
+	DenseMap<Value *, Value *> valueMap;
+	for (Instruction &inst : *header)
+	{
+		Instruction *copy = inst.clone();
+		copy->insertBefore(oldBr);
+		valueMap[&inst] = copy;
+		for (Use &op : copy->operands())
+		{
+			auto it = valueMap.find(op.get());
+			if (it != valueMap.end())
+			{
+				op.set(it->second);
+			}
+		}
+	}
+	if (MDNode *loopID = oldBr->getMetadata(LLVMContext::MD_loop))
+	{
+		oldBr->getPrevNode()->setMetadata(LLVMContext::MD_loop, loopID);
+	}
+	oldBr->eraseFromParent();
+}
+
+// top-tested loops into a guard before the loop and a single conditional branch at the bottom
+void rotateLoops(Function &func, FunctionAnalysisManager &analyses, bool &change)
+{
+	if (func.isDeclaration())
+	{
+		return;
+	}
+	bool restart = true;
+	while (restart)
+	{
+		restart = false;
+		DominatorTree &domTree = analyses.getResult<DominatorTreeAnalysis>(func);
+		passVector<naturalLoop> loops = analyses.getResult<naturalLoopAnalysis>(func).loops;
+		for (naturalLoop &loop : loops)
+		{
+			BranchInst *exitBr = dyn_cast<BranchInst>(loop.header->getTerminator());
+			BasicBlock *latch = loop.latches.size() == 1 ? loop.latches.front() : nullptr;
+			BasicBlock *preheader = getPreheader(loop);
+			if (exitBr == nullptr || exitBr->isUnconditional() || latch == nullptr || latch == loop.header ||
+					preheader == nullptr || loop.header->size() > ROTATE_HEADER_BUDGET ||
+					loop.blocks.count(exitBr->getSuccessor(0)) == loop.blocks.count(exitBr->getSuccessor(1)))
+			{
+				continue;
+			}
+			BranchInst *backBr = dyn_cast<BranchInst>(latch->getTerminator());
+			if (backBr == nullptr || backBr->isConditional())
+			{
+				continue;
+			}
+
+			// header values used outside the header would need phis once it is duplicated
+			bool local = all_of(*loop.header, [&loop](Instruction &inst)
+													{ return all_of(inst.users(), [&loop](User *user)
+																					{ return cast<Instruction>(user)->getParent() == loop.header; }); });
+			if (!local || isUnrollable(loop, computeTripCount(loop, preheader, domTree)))
+			{
+				continue;
+			}
+			log("minic-rotate", "rotated", [&]
+					{ return string{"ROT -> "} + getInstructionString(*exitBr); }, exitBr);
+			copyHeader(loop.header, preheader);
+			copyHeader(loop.header, latch);
+			loop.header->dropAllReferences();
+			loop.header->eraseFromParent();
+			change = true;
+			analyses.invalidate(func, PreservedAnalyses::none());
+			restart = true;
+			break;
+		}
+	}
+}
+
+// whether op holds subject's current value at the end of block: subject itself or a load after its last store
+bool readsSubject(Value *op, Value *subject, BasicBlock *block)
+{
+	LoadInst *load = dyn_cast<LoadInst>(op);
+	if (op == subject)
+	{
+		return true;
+	}
+	if (load == nullptr || load->getPointerOperand() != subject || load->getParent() != block)
+	{
+		return false;
+	}
+	for (Instruction *inst = load->getNextNode(); inst != nullptr; inst = inst->getNextNode())
+	{
+		StoreInst *store = dyn_cast<StoreInst>(inst);
+		if (store != nullptr && store->getPointerOperand() == subject)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// values subject can hold on the edge from pred into block, from stores and branches up the single-predecessor chain
+ConstantRange getEdgeRange(Value *subject, unsigned width, BasicBlock *pred, BasicBlock *block)
+{
+	for (unsigned depth = 0; pred != nullptr && depth < JUMP_THREAD_DEPTH; depth++)
+	{
+		BranchInst *br = dyn_cast<BranchInst>(pred->getTerminator());
+		ICmpInst *cmp = br != nullptr && br->isConditional() ? dyn_cast<ICmpInst>(br->getCondition()) : nullptr;
+		if (cmp != nullptr && br->getSuccessor(0) != br->getSuccessor(1))
+		{
+			CmpInst::Predicate cmpPred = br->getSuccessor(0) == block ? cmp->getPredicate() : cmp->getInversePredicate();
+			ConstantInt *bound = dyn_cast<ConstantInt>(cmp->getOperand(1));
+			if (bound != nullptr && readsSubject(cmp->getOperand(0), subject, pred))
+			{
+				return ConstantRange::makeAllowedICmpRegion(cmpPred, ConstantRange(bound->getValue()));
+			}
+			bound = dyn_cast<ConstantInt>(cmp->getOperand(0));
+			if (bound != nullptr && readsSubject(cmp->getOperand(1), subject, pred))
+			{
+				return ConstantRange::makeAllowedICmpRegion(CmpInst::getSwappedPredicate(cmpPred),
+																										ConstantRange(bound->getValue()));
+			}
+		}
+		for (auto it = pred->rbegin(); it != pred->rend(); it++)
+		{
+			StoreInst *store = dyn_cast<StoreInst>(&*it);
+			if (store != nullptr && store->getPointerOperand() == subject)
+			{
+				ConstantInt *value = dyn_cast<ConstantInt>(store->getValueOperand());
+				return value != nullptr ? ConstantRange(value->getValue()) : ConstantRange::getFull(width);
+			}
+		}
+		block = pred;
+		pred = pred->getSinglePredecessor();
+	}
+	return ConstantRange::getFull(width);
+}
+
+// small blocks ending in a test some predecessors already decide are copied into them, branching straight on
+void threadJumps(Function &func, FunctionAnalysisManager &analyses, bool &change)
+{
+	if (func.isDeclaration())
+	{
+		return;
+	}
+	bool restart = true;
+	while (restart)
+	{
+		restart = false;
+		DominatorTree &domTree = analyses.getResult<DominatorTreeAnalysis>(func);
+		// loop entries stay too, a threaded entry leaves a loop unrolling and rotation no longer recognise
+		SmallPtrSet<BasicBlock *, 8> headers;
+		for (naturalLoop &loop : analyses.getResult<naturalLoopAnalysis>(func).loops)
+		{
+			headers.insert(loop.header);
+		}
+		for (BasicBlock &block : func)
+		{
+			BranchInst *br = dyn_cast<BranchInst>(block.getTerminator());
+			ICmpInst *cmp = br != nullptr && br->isConditional() ? dyn_cast<ICmpInst>(br->getCondition()) : nullptr;
+			if (cmp == nullptr || cmp->getParent() != &block || &block == &func.getEntryBlock() || headers.count(&block) ||
+					block.size() > JUMP_THREAD_BUDGET || block.hasNPredecessors(1))
+			{
+				continue;
+			}
+
+			// pred(subject, bound) with subject a variable loaded before any store to it here, or a value from elsewhere
+			CmpInst::Predicate cmpPred = cmp->getPredicate();
+			Value *op = cmp->getOperand(0);
+			ConstantInt *bound = dyn_cast<ConstantInt>(cmp->getOperand(1));
+			if (bound == nullptr)
+			{
+				cmpPred = CmpInst::getSwappedPredicate(cmpPred);
+				op = cmp->getOperand(1);
+				bound = dyn_cast<ConstantInt>(cmp->getOperand(0));
+			}
+			Value *subject = op;
+			LoadInst *load = dyn_cast<LoadInst>(op);
+			if (load != nullptr && load->getParent() == &block && isTrackedAlloca(load->getPointerOperand()))
+			{
+				subject = load->getPointerOperand();
+				for (Instruction *inst = load->getPrevNode(); inst != nullptr && subject != nullptr; inst = inst->getPrevNode())
+				{
+					StoreInst *store = dyn_cast<StoreInst>(inst);
+					subject = store != nullptr && store->getPointerOperand() == subject ? nullptr : subject;
+				}
+			}
+			else if (isa<Instruction>(op) && cast<Instruction>(op)->getParent() == &block)
+			{
+				subject = nullptr;
+			}
+			// values defined here and used elsewhere would need phis once the block is copied
+			bool local = all_of(block, [&block](Instruction &inst)
+													{ return all_of(inst.users(), [&block](User *user)
+																					{ return cast<Instruction>(user)->getParent() == &block; }); });
+			if (bound == nullptr || subject == nullptr || !local)
+			{
+				continue;
+			}
+			ConstantRange allowed = ConstantRange::makeSatisfyingICmpRegion(cmpPred, ConstantRange(bound->getValue()));
+			ConstantRange denied = ConstantRange::makeSatisfyingICmpRegion(CmpInst::getInversePredicate(cmpPred),
+																																		 ConstantRange(bound->getValue()));
+
+			SmallVector<BasicBlock *, 4> preds(predecessors(&block));
+			for (BasicBlock *pred : preds)
+			{
+				// back edges stay, threading them would reshape the loop
+				Instruction *predTerm = pred->getTerminator();
+				if (domTree.dominates(&block, pred) || predTerm->getNumSuccessors() > 2 ||
+						(predTerm->getNumSuccessors() == 2 && predTerm->getSuccessor(0) == predTerm->getSuccessor(1)))
+				{
+					continue;
+				}
+				ConstantRange range = getEdgeRange(subject, bound->getBitWidth(), pred, &block);
+				BasicBlock *target = allowed.contains(range) ? br->getSuccessor(0)
+														 : denied.contains(range) ? br->getSuccessor(1)
+																											: nullptr;
+				if (target == nullptr)
+				{
+					continue;
+				}
+				log("minic-jumpthread", "threaded", [&]
+						{ return string{"JT -> "} + getInstructionString(*cmp); }, cmp);
+				BasicBlock *copy = pred;
+				if (predTerm->getNumSuccessors() > 1)
+				{
+					copy = BasicBlock::Create(func.getContext(), "", &func, &block);
+					BranchInst::Create(&block, copy);
+					predTerm->replaceSuccessorWith(&block, copy);
+				}
+				copyHeader(&block, copy);
+				copy->getTerminator()->eraseFromParent();
+				BranchInst::Create(target, copy);
+				change = true;
+				restart = true;
+				break;
+			}
+			if (restart)
+			{
+				analyses.invalidate(func, PreservedAnalyses::none());
+				break;
+			}
+		}
+	}
+}
+
+// a block's equality test of one value against a constant, subject being the variable that holds the value when the block ends
+typedef struct
+{
+	Value *subject;
+	Value *value;
+	ConstantInt *constant;
+	BasicBlock *equal;
+	BasicBlock *notEqual;
+} equalityTest;
+
+bool getEqualityTest(BasicBlock *block, equalityTest &test, bool head)
+{
+	BranchInst *br = dyn_cast<BranchInst>(block->getTerminator());
+	ICmpInst *cmp = br != nullptr && br->isConditional() ? dyn_cast<ICmpInst>(br->getCondition()) : nullptr;
+	if (cmp == nullptr || !cmp->isEquality() || cmp->getParent() != block || br->getSuccessor(0) == br->getSuccessor(1))
+	{
+		return false;
+	}
+	unsigned side = isa<ConstantInt>(cmp->getOperand(0)) ? 1 : 0;
+	test.value = cmp->getOperand(side);
+	test.constant = dyn_cast<ConstantInt>(cmp->getOperand(1 - side));
+	test.subject = test.value;
+	unsigned equalSide = cmp->getPredicate() == CmpInst::ICMP_EQ ? 0 : 1;
+	test.equal = br->getSuccessor(equalSide);
+	test.notEqual = br->getSuccessor(1 - equalSide);
+	LoadInst *load = dyn_cast<LoadInst>(test.value);
+	if (load != nullptr && load->getParent() == block && isTrackedAlloca(load->getPointerOperand()))
+	{
+		test.subject = load->getPointerOperand();
+		for (Instruction *inst = load->getNextNode(); inst != nullptr; inst = inst->getNextNode())
+		{
+			StoreInst *store = dyn_cast<StoreInst>(inst);
+			if (store != nullptr && store->getPointerOperand() == test.subject)
+			{
+				return false;
+			}
+		}
+	}
+	else if (isa<Instruction>(test.value) && cast<Instruction>(test.value)->getParent() == block)
+	{
+		// only a chain's first test may compute what it compares, later tests read it from the variable it went to
+		if (!head)
+		{
+			return false;
+		}
+		SmallPtrSet<Value *, 8> storedLater;
+		for (Instruction *inst = block->getTerminator(); inst != nullptr; inst = inst->getPrevNode())
+		{
+			StoreInst *store = dyn_cast<StoreInst>(inst);
+			if (store == nullptr || !storedLater.insert(store->getPointerOperand()).second)
+			{
+				continue;
+			}
+			if (store->getValueOperand() == test.value && isTrackedAlloca(store->getPointerOperand()))
+			{
+				test.subject = store->getPointerOperand();
+				break;
+			}
+		}
+	}
+	return test.constant != nullptr;
+}
+
+// a block doing nothing but testing the same subject as the test before it, reached only from there
+bool isChainLink(BasicBlock *block, BasicBlock *pred, equalityTest &previous, equalityTest &test)
+{
+	if (block->getSinglePredecessor() != pred || !getEqualityTest(block, test, false) ||
+			(test.subject != previous.subject && test.value != previous.value))
+	{
+		return false;
+	}
+	return all_of(*block, [block, &test](Instruction &inst)
+								{ return inst.isTerminator() || (isa<LoadInst>(inst) && &inst == test.value) ||
+												 (&inst == cast<BranchInst>(block->getTerminator())->getCondition() && inst.hasOneUse()); }) &&
+				 (test.value == test.subject || test.value->hasOneUse());
+}
+
+// if-else chains comparing one value with constants become a single switch
+void convertChainsToSwitches(Function &func, bool &change)
+{
+	SmallPtrSet<BasicBlock *, 16> absorbed;
+	passVector<BasicBlock *> dead;
+	for (BasicBlock &block : func)
+	{
+		equalityTest head, previous, test;
+		if (absorbed.count(&block) || !getEqualityTest(&block, head, true))
+		{
+			continue;
+		}
+		// start at the first test, a link further down belongs to its head's chain
+		BasicBlock *pred = block.getSinglePredecessor();
+		if (pred != nullptr && getEqualityTest(pred, previous, true) && previous.notEqual == &block && isChainLink(&block, pred, previous, test))
+		{
+			continue;
+		}
+
+		passVector<pair<ConstantInt *, BasicBlock *>> cases{make_pair(head.constant, head.equal)};
+		SmallPtrSet<ConstantInt *, 8> seen{head.constant};
+		SmallPtrSet<BasicBlock *, 8> links{&block};
+		previous = head;
+		BasicBlock *current = &block;
+		while (!links.count(previous.notEqual) && isChainLink(previous.notEqual, current, previous, test))
+		{
+			// a constant already tested can never reach this case
+			if (seen.insert(test.constant).second)
+			{
+				cases.push_back(make_pair(test.constant, test.equal));
+			}
+			current = previous.notEqual;
+			links.insert(current);
+			previous = test;
+		}
+		if (cases.size() < SWITCH_MIN_CASES)
+		{
+			continue;
+		}
+		absorbed.insert(links.begin(), links.end());
+		// the tests after the first are left without predecessors
+		for (BasicBlock *link : links)
+		{
+			if (link != &block)
+			{
+				dead.push_back(link);
+			}
+		}
+		Instruction *br = block.getTerminator();
+		SwitchInst *sw = SwitchInst::Create(head.value, previous.notEqual, cases.size(), br);
+		for (auto &entry : cases)
+		{
+			sw->addCase(entry.first, entry.second);
+		}
+		br->eraseFromParent();
+		log("minic-switch", "chains_converted", [&]
+				{ return string{"SWITCH -> "} + to_string(cases.size()) + " cases on " + getInstructionString(*sw); }, sw);
+		change = true;
+	}
+	for (BasicBlock *block : dead)
+	{
+		for (BasicBlock *succ : successors(block))
+		{
+			succ->removePredecessor(block);
+		}
+		block->dropAllReferences();
+	}
+	for (BasicBlock *block : dead)
+	{
+		block->eraseFromParent();
+	}
+}
+
+// the store to a variable that ends an arm of a branch, when everything before it is safe to run on either path
+StoreInst *getConvertibleArm(BasicBlock *arm, BasicBlock *head, BasicBlock *join, int64_t &cost)
+{
+	BranchInst *br = dyn_cast<BranchInst>(arm->getTerminator());
+	if (arm->getSinglePredecessor() != head || br == nullptr || br->isConditional() || br->getSuccessor(0) != join)
+	{
+		return nullptr;
+	}
+	StoreInst *store = nullptr;
+	for (Instruction &inst : *arm)
+	{
+		if (&inst == br)
+		{
+			break;
+		}
+		if (store != nullptr)
+		{
+			return nullptr;
+		}
+		store = dyn_cast<StoreInst>(&inst);
+		if (store != nullptr)
+		{
+			if (!isTrackedAlloca(store->getPointerOperand()))
+			{
+				return nullptr;
+			}
+			continue;
+		}
+		LoadInst *load = dyn_cast<LoadInst>(&inst);
+		if ((load == nullptr || !isTrackedAlloca(load->getPointerOperand())) && !isSpeculatable(inst))
+		{
+			return nullptr;
+		}
+		if (any_of(inst.users(), [arm](User *user)
+							 { return cast<Instruction>(user)->getParent() != arm; }))
+		{
+			return nullptr;
+		}
+		cost++;
+	}
+	return store;
+}
+
+// if/else diamonds and if triangles whose arms only assign one variable store a select instead
+void convertIfsToSelects(Function &func, bool &change)
+{
+	for (BasicBlock &block : func)
+	{
+		BranchInst *br = dyn_cast<BranchInst>(block.getTerminator());
+		if (br == nullptr || br->isUnconditional() || br->getSuccessor(0) == br->getSuccessor(1))
+		{
+			continue;
+		}
+		BasicBlock *thenBlock = br->getSuccessor(0);
+		BasicBlock *elseBlock = br->getSuccessor(1);
+		BasicBlock *join = thenBlock->getSingleSuccessor();
+		if (elseBlock->getSingleSuccessor() == thenBlock)
+		{
+			join = thenBlock;
+		}
+		else if (join != elseBlock && join != elseBlock->getSingleSuccessor())
+		{
+			join = nullptr;
+		}
+		if (join == nullptr || join == &block || isa<PHINode>(join->front()))
+		{
+			continue;
+		}
+
+		int64_t cost = 0;
+		StoreInst *thenStore = thenBlock != join ? getConvertibleArm(thenBlock, &block, join, cost) : nullptr;
+		StoreInst *elseStore = elseBlock != join ? getConvertibleArm(elseBlock, &block, join, cost) : nullptr;
+		if ((thenBlock != join && thenStore == nullptr) || (elseBlock != join && elseStore == nullptr) ||
+				(thenStore != nullptr && elseStore != nullptr && thenStore->getPointerOperand() != elseStore->getPointerOperand()))
+		{
+			continue;
+		}
+		// both arms run unconditionally once converted, a long arm costs more than a missed prediction
+		if (cost > IF_CONVERT_BUDGET)
+		{
+			missed("minic-ifconvert", "too_large", br, [&]
+						 { return "branch not converted to a select, its arms compute " + to_string(cost) +
+											" instructions, over the budget of " + to_string(IF_CONVERT_BUDGET); });
+			continue;
+		}
+
+		for (BasicBlock *arm : {thenBlock, elseBlock})
+		{
+			while (arm != join && !isa<StoreInst>(arm->front()))
+			{
+				arm->front().moveBefore(br);
+			}
+		}
+		AllocaInst *variable = cast<AllocaInst>((thenStore != nullptr ? thenStore : elseStore)->getPointerOperand());
+		IRBuilder<> builder(br);
+		Value *unchanged = thenStore == nullptr || elseStore == nullptr ? builder.CreateLoad(variable->getAllocatedType(), variable) : nullptr;
+		Value *select = builder.CreateSelect(br->getCondition(),
+																				 thenStore != nullptr ? thenStore->getValueOperand() : unchanged,
+																				 elseStore != nullptr ? elseStore->getValueOperand() : unchanged);
+		builder.CreateStore(select, variable);
+		log("minic-ifconvert", "converted", [&]
+				{ return string{"SELECT -> "} + getInstructionString(*cast<Instruction>(select)); }, cast<Instruction>(select));
+		BranchInst::Create(join, br);
+		br->eraseFromParent();
+		for (BasicBlock *arm : {thenBlock, elseBlock})
+		{
+			if (arm != join)
+			{
+				arm->dropAllReferences();
+				arm->eraseFromParent();
+			}
+		}
+		change = true;
+	}
+}
+
+// whether a value computed in one arm of an if/else and one in the other are the same computation,
+// collecting the instructions of both, operands first, when they are used only by it
+bool isSameComputation(Value *first, Value *second, StoreInst *firstEnd, StoreInst *secondEnd,
+											 passVector<pair<Instruction *, Instruction *>> &tree)
+{
+	if (first == second)
+	{
+		return !isa<Instruction>(first) || (cast<Instruction>(first)->getParent() != firstEnd->getParent() &&
+																				cast<Instruction>(first)->getParent() != secondEnd->getParent());
+	}
+	Instruction *firstInst = dyn_cast<Instruction>(first);
+	Instruction *secondInst = dyn_cast<Instruction>(second);
+	if (firstInst == nullptr || secondInst == nullptr || firstInst->getParent() != firstEnd->getParent() ||
+			secondInst->getParent() != secondEnd->getParent() || !firstInst->hasOneUse() || !secondInst->hasOneUse() ||
+			!firstInst->isSameOperationAs(secondInst))
+	{
+		return false;
+	}
+	if (LoadInst *load = dyn_cast<LoadInst>(firstInst))
+	{
+		// the load moves past the rest of its arm, which must leave the variable alone
+		auto storedAfter = [load](Instruction *inst, StoreInst *end)
+		{
+			for (inst = inst->getNextNode(); inst != end; inst = inst->getNextNode())
+			{
+				StoreInst *store = dyn_cast<StoreInst>(inst);
+				if (store != nullptr && store->getPointerOperand() == load->getPointerOperand())
+				{
+					return true;
+				}
+			}
+			return false;
+		};
+		if (!isTrackedAlloca(load->getPointerOperand()) || storedAfter(firstInst, firstEnd) || storedAfter(secondInst, secondEnd))
+		{
+			return false;
+		}
+	}
+	else if (!isSpeculatable(*firstInst))
+	{
+		return false;
+	}
+	for (unsigned op = 0; op < firstInst->getNumOperands(); op++)
+	{
+		if (!isSameComputation(firstInst->getOperand(op), secondInst->getOperand(op), firstEnd, secondEnd, tree))
+		{
+			return false;
+		}
+	}
+	tree.push_back(make_pair(firstInst, secondInst));
+	return true;
+}
+
+// computations used on one path only move down into it, and a store ending both arms of an if/else moves into the join
+void sinkInstructions(Function &func, bool &change)
+{
+	for (BasicBlock &block : func)
+	{
+		if (block.getTerminator() == nullptr || block.getTerminator()->getNumSuccessors() < 2)
+		{
+			continue;
+		}
+		SmallPtrSet<Value *, 8> storedBelow;
+		for (Instruction *inst = block.getTerminator()->getPrevNode(); inst != nullptr;)
+		{
+			Instruction *prev = inst->getPrevNode();
+			if (StoreInst *store = dyn_cast<StoreInst>(inst))
+			{
+				storedBelow.insert(store->getPointerOperand());
+			}
+			LoadInst *load = dyn_cast<LoadInst>(inst);
+			bool movable = load != nullptr ? isTrackedAlloca(load->getPointerOperand()) && !storedBelow.count(load->getPointerOperand())
+																		 : isSpeculatable(*inst);
+			BasicBlock *target = inst->use_empty() ? nullptr : cast<Instruction>(*inst->user_begin())->getParent();
+			// a block reached only from here runs the instruction exactly when it is needed
+			if (movable && target != nullptr && target != &block && target->getSinglePredecessor() == &block &&
+					all_of(inst->users(), [target](User *user)
+								 { return cast<Instruction>(user)->getParent() == target; }))
+			{
+				log("minic-sink", "sunk", [&]
+						{ return string{"SINK -> "} + getInstructionString(*inst); }, inst);
+				inst->moveBefore(&*target->getFirstInsertionPt());
+				change = true;
+			}
+			inst = prev;
+		}
+	}
+
+	for (BasicBlock &join : func)
+	{
+		SmallVector<BasicBlock *, 2> arms(predecessors(&join));
+		if (arms.size() != 2 || arms[0] == arms[1] || arms[0] == &join || arms[1] == &join || isa<PHINode>(join.front()))
+		{
+			continue;
+		}
+		// stores are merged from the end of the arms up, each one in front of those merged before it
+		Instruction *insertPoint = &*join.getFirstInsertionPt();
+		while (true)
+		{
+			StoreInst *ends[2];
+			for (int arm = 0; arm < 2; arm++)
+			{
+				BranchInst *br = dyn_cast<BranchInst>(arms[arm]->getTerminator());
+				ends[arm] = br != nullptr && br->isUnconditional() ? dyn_cast_or_null<StoreInst>(br->getPrevNode()) : nullptr;
+			}
+			passVector<pair<Instruction *, Instruction *>> tree;
+			if (ends[0] == nullptr || ends[1] == nullptr || ends[0]->getPointerOperand() != ends[1]->getPointerOperand() ||
+					!isTrackedAlloca(ends[0]->getPointerOperand()) ||
+					!isSameComputation(ends[0]->getValueOperand(), ends[1]->getValueOperand(), ends[0], ends[1], tree))
+			{
+				break;
+			}
+			log("minic-sink", "stores_merged", [&]
+					{ return string{"SINK -> merged "} + getInstructionString(*ends[0]); }, ends[0]);
+			for (auto &copies : tree)
+			{
+				copies.first->moveBefore(insertPoint);
+			}
+			ends[0]->moveBefore(insertPoint);
+			insertPoint = tree.empty() ? ends[0] : tree.front().first;
+			ends[1]->eraseFromParent();
+			for (auto copies = tree.rbegin(); copies != tree.rend(); copies++)
+			{
+				copies->second->eraseFromParent();
+			}
+			change = true;
+		}
+	}
+}
+
+// with branch weights from a profile, chain each block to its more likely successor
+void layoutBlocks(Function &func, bool &change)
+{
+	bool profiled = any_of(func, [](BasicBlock &block)
+												 { return block.getTerminator() != nullptr && block.getTerminator()->getMetadata(LLVMContext::MD_prof) != nullptr; });
+	if (!profiled)
+	{
+		return;
+	}
+	auto likelySuccessor = [](BasicBlock *block) -> BasicBlock *
+	{
+		BranchInst *br = dyn_cast<BranchInst>(block->getTerminator());
+		uint64_t taken, notTaken;
+		if (br == nullptr)
+		{
+			return nullptr;
+		}
+		if (br->isUnconditional())
+		{
+			return br->getSuccessor(0);
+		}
+		if (!br->extractProfMetadata(taken, notTaken))
+		{
+			return nullptr;
+		}
+		return br->getSuccessor(taken >= notTaken ? 0 : 1);
+	};
+
+	passVector<BasicBlock *> original;
+	for (BasicBlock &block : func)
+	{
+		original.push_back(&block);
+	}
+	passVector<BasicBlock *> layout;
+	SmallPtrSet<BasicBlock *, 16> placed;
+	for (BasicBlock *start : original)
+	{
+		for (BasicBlock *block = start; block != nullptr && placed.insert(block).second; block = likelySuccessor(block))
+		{
+			layout.push_back(block);
+		}
+	}
+	if (layout == original)
+	{
+		return;
+	}
+	log("minic-layout", "functions_reordered", [&]
+			{ return string{"LAYOUT -> "} + func.getName().str(); });
+	for (unsigned i = 1; i < layout.size(); i++)
+	{
+		layout[i]->moveAfter(layout[i - 1]);
+	}
+	change = true;
+}
+
+template <void (*Transform)(BasicBlock &, bool &)>
+void runOnBlocks(Function &func, bool &change)
+{
+	for (BasicBlock &block : func)
+	{
+		Transform(block, change);
+	}
+}
+
+// every block followed by its successors, equal before and after a pass that left the cfg alone
+vector<BasicBlock *> getControlFlow(Function &func)
+{
+	vector<BasicBlock *> cfg;
+	for (BasicBlock &block : func)
+	{
+		cfg.push_back(&block);
+		cfg.insert(cfg.end(), succ_begin(&block), succ_end(&block));
+		cfg.push_back(nullptr);
+	}
+	return cfg;
+}
+
+// a custom pass as a new pass manager function pass, transforms taking the analysis manager share its cached analyses
+template <auto Transform>
+struct customPass : PassInfoMixin<customPass<Transform>>
+{
+	string passName;
+
+	customPass(string passName) : passName(passName) {}
+
+	PreservedAnalyses run(Function &func, FunctionAnalysisManager &analyses)
+	{
+		auto start = chrono::steady_clock::now();
+		uint64_t allocations = allocationCount;
+		vector<BasicBlock *> cfg = getControlFlow(func);
+		bool change = false;
+		if constexpr (is_invocable_v<decltype(Transform), Function &, FunctionAnalysisManager &, bool &>)
+		{
+			Transform(func, analyses, change);
+		}
+		else
+		{
+			Transform(func, change);
+		}
+		statistics[passName]["allocations"] += allocationCount - allocations;
+		statistics[passName]["runs"]++;
+		statistics[passName]["changes"] += change;
+		statistics[passName]["time_us"] += chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+		if (!change)
+		{
+			return PreservedAnalyses::all();
+		}
+		PreservedAnalyses preserved;
+		if (cfg == getControlFlow(func))
+		{
+			preserved.preserveSet<CFGAnalyses>();
+		}
+		return preserved;
+	}
+};
+
+// reruns its passes until none of them changes the function, giving up after FIXPOINT_ITERATION_LIMIT rounds
+struct fixpointPass : PassInfoMixin<fixpointPass>
+{
+	FunctionPassManager passes;
+	vector<string> names;
+
+	PreservedAnalyses run(Function &func, FunctionAnalysisManager &analysisManager)
+	{
+		PreservedAnalyses preserved = PreservedAnalyses::all();
+		map<string, uint64_t> changes;
+		for (int round = 0; round < FIXPOINT_ITERATION_LIMIT; round++)
+		{
+			statistics["minic"]["iterations"]++;
+			for (string &name : names)
+			{
+				changes[name] = statistics[name]["changes"];
+			}
+			PreservedAnalyses iteration = passes.run(func, analysisManager);
+			if (iteration.areAllPreserved())
+			{
+				return preserved;
+			}
+			preserved.intersect(move(iteration));
+		}
+		// passes undoing each other's work never settle, name the ones still changing in the last round
+		string still;
+		for (string &name : names)
+		{
+			if (statistics[name]["changes"] != changes[name])
+			{
+				still += " " + name;
+			}
+		}
+		log("minic", "limit_reached", [&]
+				{ return "FIXPOINT -> " + func.getName().str() + " still changing after " + to_string(FIXPOINT_ITERATION_LIMIT) +
+								 " iterations in" + still; });
+		return preserved;
+	}
+};
+
+map<string, function<void(FunctionPassManager &, string)>> customPasses = {
+		{"minic-cse", [](FunctionPassManager &passes, string name)
+		 { passes.addPass(customPass<runOnBlocks<eliminateCommonSubExpression>>(name)); }},
+		{"minic-dce", [](FunctionPassManager &passes, string name)
+		 { passes.addPass(customPass<runOnBlocks<eliminateDeadCode>>(name)); }},
+		{"minic-constfold", [](FunctionPassManager &passes, string name)
+		 { passes.addPass(customPass<runOnBlocks<constantFolding>>(name)); }},
+		{"minic-combine", [](FunctionPassManager &passes, string name)
+		 { passes.addPass(customPass<runOnBlocks<combineInstructions>>(name)); }},
+		{"minic-reassociate", [](FunctionPassManager &passes, string name)
+		 { passes.addPass(customPass<reassociateExpressions>(name)); }},
+		{"minic-constprop", [](FunctionPassManager &passes, string name)
+		 { passes.addPass(customPass<constantPropagation>(name)); }},
+		{"minic-sccp", [](FunctionPassManager &passes, string name)
+		 { passes.addPass(customPass<sparseConditionalConstantPropagation>(name)); }},
+		{"minic-vrp", [](FunctionPassManager &passes, string name)
+		 { passes.addPass(customPass<eliminateRedundantComparisons>(name)); }},
+		{"minic-pre", [](FunctionPassManager &passes, string name)
+		 { passes.addPass(customPass<eliminatePartialRedundancies>(name)); }},
+		{"minic-dse", [](FunctionPassManager &passes, string name)
+		 { passes.addPass(customPass<eliminateDeadStores>(name)); }},
+		{"minic-simplifycfg", [](FunctionPassManager &passes, string name)
+		 { passes.addPass(customPass<simplifyControlFlow>(name)); }},
+		{"minic-switch", [](FunctionPassManager &passes, string name)
+		 { passes.addPass(customPass<convertChainsToSwitches>(name)); }},
+		{"minic-jumpthread", [](FunctionPassManager &passes, string name)
+		 { passes.addPass(customPass<threadJumps>(name)); }},
+		{"minic-licm", [](FunctionPassManager &passes, string name)
+		 { passes.addPass(customPass<hoistLoopInvariants>(name)); }},
+		{"minic-unswitch", [](FunctionPassManager &passes, string name)
+		 { passes.addPass(customPass<unswitchLoops>(name)); }},
+		{"minic-ifconvert", [](FunctionPassManager &passes, string name)
+		 { passes.addPass(customPass<convertIfsToSelects>(name)); }},
+		{"minic-sink", [](FunctionPassManager &passes, string name)
+		 { passes.addPass(customPass<sinkInstructions>(name)); }},
+		{"minic-unroll", [](FunctionPassManager &passes, string name)
+		 { passes.addPass(customPass<unrollLoops>(name)); }},
+		{"minic-iv", [](FunctionPassManager &passes, string name)
+		 { passes.addPass(customPass<reduceInductionVariables>(name)); }},
+		{"minic-rotate", [](FunctionPassManager &passes, string name)
+		 { passes.addPass(customPass<rotateLoops>(name)); }},
+		{"minic-layout", [](FunctionPassManager &passes, string name)
+		 { passes.addPass(customPass<layoutBlocks>(name)); }},
+};
+
+// order the custom passes run in on every fixpoint iteration
+vector<string> customPipeline = {
+		"minic-cse", "minic-dce", "minic-constfold", "minic-combine",
+		"minic-reassociate", "minic-constprop", "minic-sccp", "minic-vrp",
+		"minic-pre", "minic-dse", "minic-simplifycfg", "minic-switch",
+		"minic-jumpthread", "minic-licm", "minic-unswitch", "minic-ifconvert",
+		"minic-sink", "minic-unroll", "minic-iv", "minic-rotate", "minic-layout"};
+
+fixpointPass createCustomPipeline()
+{
+	fixpointPass pipeline;
+	for (string &name : customPipeline)
+	{
+		customPasses[name](pipeline.passes, name);
+		pipeline.names.push_back(name);
+	}
+	return pipeline;
+}
+
+// "minic" is the whole custom pipeline, minic-* the single passes
+bool addCustomPass(StringRef name, FunctionPassManager &passes)
+{
+	if (name == "minic")
+	{
+		passes.addPass(createCustomPipeline());
+		return true;
+	}
+	auto it = customPasses.find(name.str());
+	if (it == customPasses.end())
+	{
+		return false;
+	}
+	it->second(passes, it->first);
+	return true;
+}
+
+void printStatistics(ostream &out, bool json)
+{
+	if (json)
+	{
+		out << "{";
+		for (auto pass = statistics.begin(); pass != statistics.end(); pass++)
+		{
+			out << (pass == statistics.begin() ? "" : ",") << "\n  \"" << pass->first << "\": {";
+			for (auto counter = pass->second.begin(); counter != pass->second.end(); counter++)
+			{
+				out << (counter == pass->second.begin() ? "" : ", ") << "\"" << counter->first << "\": " << counter->second;
+			}
+			out << "}";
+		}
+		out << "\n}" << endl;
+		return;
+	}
+	out << left << setw(20) << "pass" << setw(22) << "counter" << "value" << endl;
+	for (auto &pass : statistics)
+	{
+		for (auto &counter : pass.second)
+		{
+			out << left << setw(20) << pass.first << setw(22) << counter.first << counter.second << endl;
+		}
+	}
+}
+
+void optimizeModule(Module &module, optimizerOptions options)
+{
+	traceEnabled = traceEnabled || options.trace;
+	statistics.clear();
+	if (options.level == 0)
+	{
+		return;
+	}
+	unique_ptr<ToolOutputFile> remarksFile;
+	if (!options.remarks.empty())
+	{
+		Expected<unique_ptr<ToolOutputFile>> opened = setupLLVMOptimizationRemarks(module.getContext(), options.remarks, "", "yaml", false);
+		if (!opened)
+		{
+			cerr << "Cannot write remarks: " << toString(opened.takeError()) << endl;
+			exit(1);
+		}
+		remarksFile = move(*opened);
+		remarksEnabled = true;
+		missedRemarks.clear();
+	}
+	LoopAnalysisManager loopAnalysisManager;
+	FunctionAnalysisManager functionAnalysisManager;
+	CGSCCAnalysisManager cgsccAnalysisManager;
+	ModuleAnalysisManager moduleAnalysisManager;
+	PassBuilder passBuilder;
+	passBuilder.registerPipelineParsingCallback(
+			[](StringRef name, FunctionPassManager &passes, ArrayRef<PassBuilder::PipelineElement>)
+			{ return addCustomPass(name, passes); });
+	passBuilder.registerModuleAnalyses(moduleAnalysisManager);
+	passBuilder.registerCGSCCAnalyses(cgsccAnalysisManager);
+	functionAnalysisManager.registerPass([]
+																			{ return naturalLoopAnalysis(); });
+	functionAnalysisManager.registerPass([]
+																			{ return reachingStoresAnalysis(); });
+	functionAnalysisManager.registerPass([]
+																			{ return livenessAnalysis(); });
+	passBuilder.registerFunctionAnalyses(functionAnalysisManager);
+	passBuilder.registerLoopAnalyses(loopAnalysisManager);
+	passBuilder.crossRegisterProxies(loopAnalysisManager, functionAnalysisManager, cgsccAnalysisManager, moduleAnalysisManager);
+
+	OptimizationLevel level = options.level == 1 ? OptimizationLevel::O1 : (options.level == 2 ? OptimizationLevel::O2 : OptimizationLevel::O3);
+	ModulePassManager modulePasses;
+	if (options.pipeline == "custom" || options.pipeline == "mixed")
+	{
+		modulePasses.addPass(createModuleToFunctionPassAdaptor(createCustomPipeline()));
+	}
+	if (options.pipeline == "llvm" || options.pipeline == "mixed")
+	{
+		modulePasses.addPass(passBuilder.buildPerModuleDefaultPipeline(level));
+	}
+	if (options.pipeline != "custom" && options.pipeline != "llvm" && options.pipeline != "mixed")
+	{
+		// a textual pipeline, custom passes can be named next to llvm ones
+		if (Error err = passBuilder.parsePassPipeline(modulePasses, options.pipeline))
+		{
+			cerr << "Invalid pass pipeline: " << toString(move(err)) << endl;
+			exit(1);
+		}
+	}
+	modulePasses.run(module, moduleAnalysisManager);
+	if (remarksFile)
+	{
+		// code generation runs after the file is closed
+		module.getContext().setLLVMRemarkStreamer(nullptr);
+		module.getContext().setMainRemarkStreamer(nullptr);
+		remarksFile->keep();
+		remarksEnabled = false;
+	}
+
+	if (options.stats == "table")
+	{
+		printStatistics(cerr, false);
+	}
+	else if (!options.stats.empty())
+	{
+		ofstream statsFile(options.stats);
+		printStatistics(statsFile, true);
 	}
 }
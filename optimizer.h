@@ -4,8 +4,25 @@
  * @brief optimizer with LLVM
  * constant folding
  * common sub-expression
+ * partial redundancy elimination
  * dead code
  * constant propagation
+ * algebraic simplification
+ * reassociation
+ * sparse conditional constant propagation
+ * value-range analysis
+ * dead store elimination
+ * control-flow simplification
+ * if-chain to switch conversion
+ * jump threading
+ * loop-invariant code motion
+ * loop unswitching
+ * if-conversion to selects
+ * code sinking and store merging
+ * induction-variable strength reduction
+ * loop unrolling
+ * loop rotation
+ * profile-guided block layout
  *
  * @version 0.1
  * @date 2023-05-04
@@ -22,24 +39,45 @@
 #include <vector>
 #include <string>
 #include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <functional>
 #include <fstream>
 #include <cassert>
+#include <tuple>
+#include <type_traits>
 #include <llvm/IR/Type.h>
 #include <llvm/IR/Value.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IRReader/IRReader.h>
 #include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/MDBuilder.h>
+#include <llvm/IR/DiagnosticInfo.h>
+#include <llvm/IR/LLVMRemarkStreamer.h>
+#include <llvm/Remarks/RemarkStreamer.h>
+#include <llvm/Support/ToolOutputFile.h>
 #include <llvm/Support/SourceMgr.h>
 #include <llvm/Support/Error.h>
 #include <llvm/IR/Constants.h>
+#include <llvm/IR/ConstantRange.h>
 #include <llvm/IR/Instruction.h>
 #include <llvm/IR/Instructions.h>
 #include <llvm/IR/BasicBlock.h>
 #include <llvm/IR/Function.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/CFG.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/Support/raw_os_ostream.h>
 #include <llvm/IR/User.h>
+#include <llvm/ADT/BitVector.h>
+#include <llvm/ADT/PostOrderIterator.h>
+#include <llvm/ADT/DepthFirstIterator.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/DenseSet.h>
+#include <llvm/ADT/MapVector.h>
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/ADT/SmallVector.h>
 #include "llvm/Support/Host.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/ADT/Optional.h"
@@ -55,10 +93,82 @@
 #include "llvm/Support/CodeGen.h"
 #include <llvm/Support/FileSystem.h>
 #include <llvm/IR/Verifier.h>
+#include <llvm/IR/PassManager.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Passes/OptimizationLevel.h>
 #include <llvm/Support/TargetSelect.h>
 #include "ast.h"
 
+// copies of the loop body per iteration when partially unrolling
+#ifndef UNROLL_FACTOR
+#define UNROLL_FACTOR 4
+#endif
+// instruction limits for fully and partially unrolled loops
+#define FULL_UNROLL_BUDGET 128
+#define PARTIAL_UNROLL_BUDGET 256
+#define MAX_TRIP_COUNT 1000000
+// largest loop unswitching copies, and the function size at which it stops
+#ifndef UNSWITCH_BUDGET
+#define UNSWITCH_BUDGET 64
+#endif
+#define UNSWITCH_FUNCTION_BUDGET (UNSWITCH_BUDGET * 16)
+// largest loop header duplicated by loop rotation
+#define ROTATE_HEADER_BUDGET 16
+// instructions both arms of a branch may compute before it becomes a select
+#define IF_CONVERT_BUDGET 4
+// cost of keeping a partially redundant value in a temp, a store and a load, that recomputing it must exceed
+#define PRE_TEMP_COST 2
+// equality tests of one value an if-else chain needs to become a switch
+#define SWITCH_MIN_CASES 3
+// largest block jump threading copies, and predecessors it searches for a known outcome
+#define JUMP_THREAD_BUDGET 8
+#define JUMP_THREAD_DEPTH 4
+// loop header executions from which a profiled loop gets double unroll budgets
+#define PROFILE_HOT_COUNT 1000
+// rounds of the custom pipeline before it stops waiting for the passes to settle
+#ifndef FIXPOINT_ITERATION_LIMIT
+#define FIXPOINT_ITERATION_LIMIT 32
+#endif
+// times a block's ranges may change before value-range analysis widens them
+#define RANGE_WIDENING_ROUNDS 3
+
 using namespace std;
 
-void optimizeModule(llvm::Module &module);
+// heap allocations by the passes' own containers, the allocations statistic
+extern uint64_t allocationCount;
+
+// std allocator that counts what the passes allocate, leaving llvm's and the front end's allocations out
+template <typename T>
+struct passAllocator : allocator<T>
+{
+	passAllocator() = default;
+	template <typename U>
+	passAllocator(const passAllocator<U> &) {}
+
+	T *allocate(size_t n)
+	{
+		allocationCount++;
+		return allocator<T>::allocate(n);
+	}
+};
+
+template <typename T>
+using passVector = vector<T, passAllocator<T>>;
+template <typename Key, typename T, typename Compare = less<Key>>
+using passMap = map<Key, T, Compare, passAllocator<pair<const Key, T>>>;
+template <typename Key, typename Compare = less<Key>>
+using passSet = set<Key, Compare, passAllocator<Key>>;
+
+typedef struct
+{
+	unsigned level;		 // 0-3 as in -O0 to -O3
+	string pipeline; // custom, llvm, mixed or a textual pass pipeline
+	bool trace;			 // print every transformation as it happens
+	string stats;		 // empty, table for a summary on stderr, or a json file path
+	bool instrument; // count conditional branch edges for a profile
+	string profile;	 // profile file giving branch weights
+	string remarks;	 // yaml file for applied and missed transformations, keyed by source line
+} optimizerOptions;
+
+void optimizeModule(llvm::Module &module, optimizerOptions options);
 #endif
@@ -22,7 +22,7 @@ astNode *root;
 	vector<var_type> *type_vec_ptr;
 }
 
-%token EXTERN RETURN COMMA PTR
+%token EXTERN PURE RETURN COMMA PTR
 %token IF ELSE WHILE
 %token <ival> NUM CHAR
 %token <vname> VAR TYPE OP
@@ -60,6 +60,12 @@ ext: EXTERN type VAR '(' argTypes ')' ';' {
 	$$->ext.args = $5;
 	$$->ext.type = $2;
 	free($3);
+} | EXTERN PURE type VAR '(' argTypes ')' ';' {
+	$$ = createExtern($4);
+	$$->ext.args = $6;
+	$$->ext.type = $3;
+	$$->ext.pure = true;
+	free($4);
 }
 
 argTypes: argTypes COMMA type {
@@ -299,12 +305,36 @@ unary: OP operand {
 
 int main(int argc, char** argv){
 	// yydebug = 1;
-	if (argc == 3){
+	optimizerOptions options = {1, "custom", false, "", false, "", ""};
+	if (argc >= 3){
 		yyin = fopen(argv[1], "r");
 	} else {
-		fprintf(stderr, "Invalid number of argument ./? <input_file> [output_file]");
+		fprintf(stderr, "Invalid number of argument ./? <input_file> [output_file] [-O0|-O1|-O2|-O3] [--passes=custom|llvm|mixed|<pipeline>] [--trace] [--stats[=<file>.json]] [--instrument] [--profile-use=<file>] [--remarks=<file>.yaml]");
 		exit(1);
 	}
+	for (int i = 3; i < argc; i++) {
+		string arg = string{argv[i]};
+		if (arg.size() == 3 && arg.rfind("-O", 0) == 0 && arg[2] >= '0' && arg[2] <= '3') {
+			options.level = arg[2] - '0';
+		} else if (arg.rfind("--passes=", 0) == 0) {
+			options.pipeline = arg.substr(string{"--passes="}.size());
+		} else if (arg == "--trace") {
+			options.trace = true;
+		} else if (arg == "--stats") {
+			options.stats = "table";
+		} else if (arg.rfind("--stats=", 0) == 0) {
+			options.stats = arg.substr(string{"--stats="}.size());
+		} else if (arg == "--instrument") {
+			options.instrument = true;
+		} else if (arg.rfind("--profile-use=", 0) == 0) {
+			options.profile = arg.substr(string{"--profile-use="}.size());
+		} else if (arg.rfind("--remarks=", 0) == 0) {
+			options.remarks = arg.substr(string{"--remarks="}.size());
+		} else {
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			exit(1);
+		}
+	}
 	root = nullptr;
 	yyparse();
 	if (root) {
@@ -312,7 +342,7 @@ int main(int argc, char** argv){
 		analyzer_t *analyzer = createAnalyzer();
 		analyze(analyzer, root);
 		deleteAnalyzer(analyzer);
-		generateIR(root, string{argv[1]}, string{argv[2]});
+		generateIR(root, string{argv[1]}, string{argv[2]}, options);
 		freeNode(root);
 	} else {
 		
@@ -0,0 +1,19 @@
+extern void print(int);
+extern int read();
+
+int func(int i)
+{
+	int x;
+	int a;
+	int b;
+	int c;
+
+	x = read();
+	a = x * 8 + 0;
+	b = (x * 10 + 7) / 5;
+	c = x - x + a * 1;
+	print(a);
+	print(b);
+	print(c);
+	return b;
+}
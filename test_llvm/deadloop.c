@@ -0,0 +1,23 @@
+extern void print(int);
+
+int func(int i)
+{
+	int k0;
+	int k1;
+	int s;
+
+	s = i;
+	k0 = 5;
+	while (k0 < 0)
+	{
+		k1 = 0;
+		while (k1 < 3)
+		{
+			s = s + k1 * i;
+			k1 = k1 + 1;
+		}
+		k0 = k0 + 1;
+	}
+	print(s);
+	return s;
+}
@@ -0,0 +1,17 @@
+extern void print(int);
+extern int read();
+
+int func(int i)
+{
+	int x;
+	int unused;
+	int y;
+
+	x = read();
+	y = 1;
+	unused = x * 3;
+	y = x + 2;
+	unused = 5;
+	print(y);
+	return y;
+}
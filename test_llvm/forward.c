@@ -0,0 +1,22 @@
+extern void print(int);
+extern int read();
+
+int func(int i)
+{
+	int x;
+	int y;
+	int z;
+
+	x = read();
+	y = x + 5;
+	if (i > 0)
+	{
+		z = y * 2;
+	}
+	else
+	{
+		z = y * 3;
+	}
+	print(z + y);
+	return y;
+}
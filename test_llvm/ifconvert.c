@@ -0,0 +1,27 @@
+extern void print(int);
+extern int read();
+
+int func(int i)
+{
+	int x;
+	int m;
+	int s;
+
+	x = read();
+	m = i;
+	if (x > m)
+	{
+		m = x;
+	}
+	if (x > 3)
+	{
+		s = x + 1;
+	}
+	else
+	{
+		s = x - 1;
+	}
+	print(m);
+	print(s);
+	return m;
+}
@@ -0,0 +1,20 @@
+extern void print(int);
+extern int read();
+
+int func(int i)
+{
+	int j;
+	int s;
+	int n;
+
+	n = read();
+	s = 0;
+	j = 0;
+	while (j < n * 3)
+	{
+		s = s + j * 5;
+		j = j + 1;
+	}
+	print(s);
+	return s;
+}
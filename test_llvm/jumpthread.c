@@ -0,0 +1,33 @@
+extern void print(int);
+extern int read();
+
+int func(int i)
+{
+	int x;
+	int s;
+
+	x = read();
+	s = 0;
+	if (x == 1)
+	{
+		s = 10;
+	}
+	else if (x == 2)
+	{
+		s = 20;
+	}
+	else if (x == 4)
+	{
+		s = 40;
+	}
+	if (x == 4)
+	{
+		s = s + 1;
+	}
+	if (x == 4)
+	{
+		s = s * 2;
+	}
+	print(s);
+	return s;
+}
@@ -0,0 +1,27 @@
+extern void print(int);
+extern int read();
+
+int func(int i)
+{
+	int j;
+	int s;
+	int n;
+
+	n = read();
+	s = 0;
+	j = 0;
+	while (j < n * 50)
+	{
+		if (j == 77)
+		{
+			s = s - 100;
+		}
+		else
+		{
+			s = s + 1;
+		}
+		j = j + 1;
+	}
+	print(s);
+	return s;
+}
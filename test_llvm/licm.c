@@ -0,0 +1,20 @@
+extern void print(int);
+extern int read();
+
+int func(int i)
+{
+	int j;
+	int s;
+	int k;
+
+	k = read();
+	s = 0;
+	j = 0;
+	while (j < k * 10)
+	{
+		s = s + i * 7 + k;
+		j = j + 1;
+	}
+	print(s);
+	return s;
+}
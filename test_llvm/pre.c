@@ -0,0 +1,18 @@
+extern void print(int);
+extern int read();
+
+int func(int i)
+{
+	int x;
+	int s;
+
+	x = read();
+	s = 0;
+	if (i > 2)
+	{
+		s = x * i;
+	}
+	s = s + x * i;
+	print(s);
+	return s;
+}
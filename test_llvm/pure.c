@@ -0,0 +1,22 @@
+extern void print(int);
+extern pure int square(int);
+
+int func(int i)
+{
+	int j;
+	int s;
+	int q;
+
+	s = 0;
+	j = 0;
+	while (j < 10)
+	{
+		q = square(i);
+		s = s + q;
+		q = square(i);
+		s = s + q;
+		j = j + 1;
+	}
+	print(s);
+	return s;
+}
@@ -0,0 +1,15 @@
+extern void print(int);
+extern int read();
+
+int func(int i)
+{
+	int x;
+	int a;
+
+	x = read();
+	a = 2 + x + 3 + i + 4;
+	print(a);
+	a = 2 * x * 3 * 4;
+	print(a);
+	return a;
+}
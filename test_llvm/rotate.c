@@ -0,0 +1,20 @@
+extern void print(int);
+extern int read();
+
+int func(int i)
+{
+	int n;
+	int j;
+	int s;
+
+	n = read();
+	s = 1;
+	j = 0;
+	while (j < n)
+	{
+		s = s * 2 + j;
+		j = j + 1;
+	}
+	print(s);
+	return s;
+}
@@ -0,0 +1,22 @@
+extern void print(int);
+
+int func(int i)
+{
+	int a;
+	int b;
+	int c;
+
+	a = 3;
+	b = a * 4;
+	if (b > 10)
+	{
+		c = b + 1;
+	}
+	else
+	{
+		c = i;
+		print(c);
+	}
+	print(c);
+	return c;
+}
@@ -0,0 +1,25 @@
+extern void print(int);
+extern int read();
+
+int func(int i)
+{
+	int x;
+	int s;
+
+	x = read();
+	s = 0;
+	if (i == 3)
+	{
+		s = x;
+	}
+	{
+		if (x > 100)
+		{
+		}
+		else
+		{
+		}
+	}
+	print(s);
+	return s;
+}
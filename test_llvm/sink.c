@@ -0,0 +1,25 @@
+extern void print(int);
+extern int read();
+
+int func(int i)
+{
+	int x;
+	int a;
+	int c;
+
+	x = read();
+	c = 0;
+	a = x * 7 + i;
+	if (x > 2)
+	{
+		print(a);
+		c = i + 1;
+	}
+	else
+	{
+		print(x);
+		c = i + 1;
+	}
+	print(c);
+	return c;
+}
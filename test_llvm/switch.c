@@ -0,0 +1,35 @@
+extern void print(int);
+extern int read();
+
+int func(int i)
+{
+	int x;
+	int s;
+
+	x = read();
+	if (x == 1)
+	{
+		s = 11;
+	}
+	else if (x == 2)
+	{
+		s = 22;
+		print(s);
+	}
+	else if (x == 4)
+	{
+		s = 44;
+		print(x);
+	}
+	else if (x == 9)
+	{
+		s = 99;
+		print(i);
+	}
+	else
+	{
+		s = 0;
+	}
+	print(s);
+	return s;
+}
@@ -0,0 +1,27 @@
+extern void print(int);
+
+int func(int i)
+{
+	int j;
+	int s;
+	int t;
+
+	s = 0;
+	j = 0;
+	while (j < 10)
+	{
+		s = s + j;
+		j = j + 1;
+	}
+	print(s);
+
+	t = 0;
+	j = 0;
+	while (j < 200)
+	{
+		t = t + j * i;
+		j = j + 1;
+	}
+	print(t);
+	return s + t;
+}
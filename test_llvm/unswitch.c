@@ -0,0 +1,27 @@
+extern void print(int);
+extern int read();
+
+int func(int i)
+{
+	int mode;
+	int j;
+	int s;
+
+	mode = read();
+	s = 0;
+	j = 0;
+	while (j < 20)
+	{
+		if (mode > 3)
+		{
+			s = s + j;
+		}
+		else
+		{
+			s = s - j;
+		}
+		print(s);
+		j = j + 1;
+	}
+	return s;
+}
@@ -0,0 +1,37 @@
+extern void print(int);
+extern int read();
+
+int func(int i)
+{
+	int mode;
+	int j;
+	int k;
+	int s;
+
+	mode = read();
+	s = 0;
+	j = 0;
+	while (j < 4)
+	{
+		if (j > mode)
+		{
+			s = s + 1;
+		}
+		k = 0;
+		while (k < 5)
+		{
+			if (mode > 5)
+			{
+				s = s + mode * i;
+			}
+			else
+			{
+				s = s - mode;
+			}
+			k = k + 1;
+		}
+		j = j + 1;
+	}
+	print(s);
+	return s;
+}
@@ -0,0 +1,31 @@
+extern void print(int);
+extern int read();
+
+int func(int i)
+{
+	int x;
+	int s;
+
+	x = read();
+	s = 0;
+	if (x > 2)
+	{
+		if (x > 1)
+		{
+			s = 10;
+		}
+		else
+		{
+			s = 20;
+		}
+	}
+	if (x < 10)
+	{
+		if (x < 20)
+		{
+			s = s + 1;
+		}
+	}
+	print(s);
+	return s;
+}